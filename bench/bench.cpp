@@ -0,0 +1,218 @@
+// mkcc 基准套件：按参数生成一个合成页面，依次测量解析、元素表构建、代码生成、
+// compile()、样式表解析与层叠、播放器描述文件生成，结果以 JSON 输出，
+// 便于在不同版本之间直接 diff
+//
+//   mkcc_bench [--elements=N] [--depth=N] [--text=N] [--css=N] [--scripts=N]
+//              [--runs=N] [--out=FILE]
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "../include/compiler.h"
+#include "synthetic_page.h"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+struct bench_config
+{
+  synthetic_options page;
+  size_t runs = 5;
+  std::string out;  // 为空时输出到 stdout
+};
+
+// 每轮之前调用 setup（不计时），返回各轮耗时的最小值与中位数。
+// items 为每轮处理的元素（或样式规则）数
+static json measure(const std::string& name, size_t runs, size_t items,
+                    const std::function<void()>& body,
+                    const std::function<void()>& setup = nullptr)
+{
+  std::vector<double> times;
+  for (size_t run = 0; run < runs; ++run)
+  {
+    if (setup) setup();
+    auto start = std::chrono::steady_clock::now();
+    body();
+    times.push_back(std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+  }
+  std::sort(times.begin(), times.end());
+  double best = times.front();
+  std::cerr << "[mkcc] " << name << ": " << best << " ms\n";
+  return {{"name", name},
+          {"best_ms", best},
+          {"median_ms", times[times.size() / 2]},
+          {"items", items},
+          {"ns_per_item", items ? best * 1e6 / items : 0.0}};
+}
+
+static void collect_styled(const mkml_node& node,
+                           std::vector<const mkml_node*>& out)
+{
+  for (const auto& child : node.children())
+  {
+    if (child.tag == ATOM_DIV || child.tag == ATOM_P ||
+        child.tag == ATOM_BUTTON)
+      out.push_back(&child);
+    collect_styled(child, out);
+  }
+}
+
+static bool parse_args(int argc, char* argv[], bench_config& config)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    std::string key = arg.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    try
+    {
+      if (key == "--elements")
+        config.page.elements = std::stoul(value);
+      else if (key == "--depth")
+        config.page.depth = std::stoul(value);
+      else if (key == "--text")
+        config.page.text_length = std::stoul(value);
+      else if (key == "--css")
+        config.page.css_rules = std::stoul(value);
+      else if (key == "--scripts")
+        config.page.scripts = std::stoul(value);
+      else if (key == "--runs")
+        config.runs = std::max<size_t>(1, std::stoul(value));
+      else if (key == "--out" && !value.empty())
+        config.out = value;
+      else
+        throw std::invalid_argument(arg);
+    }
+    catch (const std::exception&)
+    {
+      std::cerr << "[mkcc] Unknown or invalid argument: " << arg << "\n"
+                << "Usage: mkcc_bench [--elements=N] [--depth=N] [--text=N] "
+                   "[--css=N] [--scripts=N] [--runs=N] [--out=FILE]\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  xmlInitParser();
+  bench_config config;
+  config.page.elements = 10000;
+  config.page.css_rules = 20;
+  if (!parse_args(argc, argv, config)) return 1;
+
+  const main_template& tmpl = load_main_template(MKCC_MAIN_TEMPLATE);
+  if (tmpl.insertions.empty())
+  {
+    std::cerr << "[mkcc] Cannot read template " << MKCC_MAIN_TEMPLATE << "\n";
+    return 1;
+  }
+
+  const size_t runs = config.runs;
+  const size_t elements = config.page.elements;
+  std::string page = synthetic_page(config.page);
+  mkml_document doc = parse_html_to_mkml(page);
+  const mkml_node& root = *doc.root;
+  json results = json::array();
+
+  results.push_back(measure("parse_html_to_mkml", runs, elements,
+                            [&] { parse_html_to_mkml(page); }));
+
+  // 与 generate_units 相同的样式表，供元素表与层叠两项使用
+  std::string css;
+  for (const auto& node : root.children())
+  {
+    if (node.tag != ATOM_HEAD) continue;
+    for (const auto& child : node.children())
+    {
+      if (child.tag == ATOM_STYLE) css.append(child.content).append("\n");
+    }
+  }
+  std::vector<css_rule> rules = parse_css(css);
+  std::unordered_map<std::string, uint32_t> style_index = css_style_index(rules);
+
+  results.push_back(measure("ui_table_builder", runs, elements,
+                            [&]
+                            {
+                              ui_document table;
+                              ui_string_pool pool(table.strings);
+                              ui_table_builder builder(root, style_index, table,
+                                                       pool);
+                            }));
+  results.push_back(measure("generate_units", runs, elements,
+                            [&] { generate_units(root, tmpl); }));
+
+  // compile() 会覆盖模板本身，每轮之前重新写入
+  fs::path dir = fs::temp_directory_path() / "mkcc_bench";
+  fs::create_directories(dir);
+  std::string main_cpp = (dir / "main.cpp").string();
+  std::streambuf* cout_buf = std::cout.rdbuf();
+  results.push_back(measure(
+      "compile", runs, elements,
+      [&]
+      {
+        std::cout.rdbuf(nullptr);  // 不输出 "File generated"
+        compile(root, main_cpp);
+        std::cout.rdbuf(cout_buf);
+        std::cout.clear();
+      },
+      [&] { write_file(main_cpp, tmpl.source); }));
+  fs::remove_all(dir);
+
+  results.push_back(measure("parse_css", runs, rules.size(),
+                            [&] { parse_css(css); }));
+
+  std::vector<const mkml_node*> styled;
+  for (const auto& node : root.children())
+  {
+    if (node.tag == ATOM_BODY) collect_styled(node, styled);
+  }
+  results.push_back(measure("css_resolve", runs, styled.size(),
+                            [&]
+                            {
+                              for (const mkml_node* node : styled)
+                              {
+                                std::string_view tag =
+                                    node->tag == ATOM_P ? "p" : node->name;
+                                css_resolve(style_index, tag,
+                                            node->attr(ATOM_ID),
+                                            node->attr(ATOM_CLASS));
+                              }
+                            }));
+
+  results.push_back(measure("build_ui_document", runs, elements,
+                            [&]
+                            {
+                              serialize_ui_document(build_ui_document(root));
+                            }));
+
+  json report = {{"mkcc_bench", 1},
+                 {"config",
+                  {{"elements", elements},
+                   {"depth", config.page.depth},
+                   {"text_length", config.page.text_length},
+                   {"css_rules", config.page.css_rules},
+                   {"scripts", config.page.scripts},
+                   {"runs", runs}}},
+                 {"page_bytes", page.size()},
+                 {"results", results}};
+  if (config.out.empty())
+  {
+    std::cout << report.dump(2) << "\n";
+  }
+  else if (!write_whole_file(config.out, report.dump(2) + "\n"))
+  {
+    std::cerr << "[mkcc] Cannot write " << config.out << "\n";
+    return 1;
+  }
+  return 0;
+}
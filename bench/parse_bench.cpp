@@ -0,0 +1,49 @@
+// MKML 解析基准：生成不同规模的合成页面，测量 parse_html_to_mkml 的耗时。
+// 每个元素的耗时应基本不随页面规模变化（线性扩展）
+//
+//   mkcc_parse_bench [最大元素数]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../include/compiler.h"
+#include "synthetic_page.h"
+
+static size_t count_nodes(const mkml_node& node)
+{
+  size_t n = 1;
+  for (const auto& child : node.children()) n += count_nodes(child);
+  return n;
+}
+
+int main(int argc, char* argv[])
+{
+  xmlInitParser();
+  size_t max_elements = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+  std::printf("%10s %10s %12s %12s %10s\n", "elements", "nodes", "best ms",
+              "ns/element", "arena KB");
+  for (size_t elements = 1000; elements <= max_elements; elements *= 2)
+  {
+    std::string page = synthetic_page(elements);
+    double best = 1e300;
+    size_t nodes = 0, arena = 0;
+    // 取多次运行的最小值，减少调度噪声
+    for (int run = 0; run < 5; ++run)
+    {
+      auto start = std::chrono::steady_clock::now();
+      mkml_document doc = parse_html_to_mkml(page);
+      double ms = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+      best = std::min(best, ms);
+      nodes = count_nodes(*doc.root);
+      arena = doc.arena.bytes_reserved();
+    }
+    std::printf("%10zu %10zu %12.2f %12.1f %10zu\n", elements, nodes, best,
+                best * 1e6 / elements, arena / 1024);
+  }
+  return 0;
+}
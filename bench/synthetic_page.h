@@ -0,0 +1,71 @@
+#pragma once
+#include <string>
+
+// 合成页面的规模参数，默认值即 mkcc_parse_bench / mkcc_codegen_bench 使用的页面
+struct synthetic_options
+{
+  size_t elements = 1000;
+  size_t depth = 1;        // 每组 50 个元素外层嵌套的 div 层数
+  size_t text_length = 0;  // 文本至少的字符数，0 表示不填充
+  size_t css_rules = 1;
+  size_t scripts = 0;
+};
+
+// 基准共用的合成页面：按 div 分组的段落与按钮。样式规则依次覆盖标签、
+// class、id 与 :hover 选择器，每个脚本是一个带 on_load 的小类
+inline std::string synthetic_page(const synthetic_options& options)
+{
+  std::string page =
+      "<html><head><title>bench</title><size x=\"800\" y=\"600\"></size>"
+      "<style>p { color: #333; }";
+  for (size_t i = 1; i < options.css_rules; ++i)
+  {
+    std::string n = std::to_string(i / 4);
+    switch (i % 4)
+    {
+    case 0: page += "\n.c" + n + " { color: #112233; padding: 4px; }"; break;
+    case 1: page += "\n#b" + n + ":hover { background-color: gray; }"; break;
+    case 2: page += "\n.group" + n + " { border-width: 2; }"; break;
+    default: page += "\nbutton:hover, .c" + n + ":hover { color: red; }"; break;
+    }
+  }
+  page += "</style>";
+  for (size_t i = 0; i < options.scripts; ++i)
+  {
+    std::string n = std::to_string(i);
+    page += "<script>int value_" + n + " = " + n +
+            ";\nvoid on_load() override { value_" + n + "++; }\n</script>";
+  }
+  page += "</head>\n<body>\n";
+
+  std::string open, close;
+  for (size_t level = 0; level < options.depth; ++level)
+  {
+    open += "<div class=\"group\">\n";
+    close += "</div>\n";
+  }
+  auto text = [&](std::string value)
+  {
+    while (value.size() < options.text_length) value += " lorem ipsum";
+    return value;
+  };
+  for (size_t i = 0; i < options.elements; ++i)
+  {
+    if (i % 50 == 0) page += i ? close + open : open;
+    std::string n = std::to_string(i);
+    if (i % 10 == 9)
+      page += "  <button id=\"b" + n + "\">" + text("Button " + n) + "</button>\n";
+    else
+      page += "  <p class=\"c" + std::to_string(i % 7) + "\">" +
+              text("Paragraph &amp; text " + n) + "</p>\n";
+  }
+  if (options.elements) page += close;
+  return page + "</body></html>\n";
+}
+
+inline std::string synthetic_page(size_t elements)
+{
+  synthetic_options options;
+  options.elements = elements;
+  return synthetic_page(options);
+}
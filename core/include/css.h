@@ -0,0 +1,221 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 样式表解析。只依赖标准库：mkcc 在构建时用它生成静态样式表，
+// 运行时（播放器与热重载）用它解析 .mkui 中的样式文本，都不需要正则表达式。
+//
+// 支持的语法与原先基于 std::regex 的解析一致：selector { prop: value; ... }，
+// 选择器与值中的空白全部去掉。另外跳过 /* */ 注释，逗号分隔的选择器各自生效
+
+struct css_color
+{
+  uint8_t r = 255, g = 255, b = 255, a = 255;
+};
+
+// 与运行时 Style 的默认值一一对应
+struct css_style
+{
+  css_color background{255, 255, 255, 0};
+  css_color text{0, 0, 0, 255};
+  unsigned font_size = 18;
+  float padding = 5;
+  float border_radius = 4;
+  css_color border{0, 0, 0, 100};
+  float border_thickness = 1;
+};
+
+struct css_rule
+{
+  std::string selector;
+  css_style style;
+};
+
+// 支持的颜色名与 #RRGGBB，其他值按白色处理
+inline css_color css_parse_color(std::string_view value)
+{
+  if (value == "red") return {255, 0, 0, 255};
+  if (value == "green") return {0, 255, 0, 255};
+  if (value == "blue") return {0, 0, 255, 255};
+  if (value == "black") return {0, 0, 0, 255};
+  if (value == "white") return {255, 255, 255, 255};
+  if (value == "gray") return {128, 128, 128, 255};
+  if (value == "yellow") return {255, 255, 0, 255};
+
+  if (value.size() == 7 && value[0] == '#')
+  {
+    auto hex = [&](size_t i)
+    {
+      char digits[3] = {value[i], value[i + 1], '\0'};
+      return static_cast<uint8_t>(std::strtoul(digits, nullptr, 16));
+    };
+    return {hex(1), hex(3), hex(5), 255};
+  }
+  return {};
+}
+
+namespace css_detail
+{
+inline bool is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+         c == '\v';
+}
+
+inline std::string strip_spaces(std::string_view text)
+{
+  std::string result;
+  result.reserve(text.size());
+  for (char c : text)
+  {
+    if (!is_space(c)) result += c;
+  }
+  return result;
+}
+
+// 数值可以带单位（如 12px），只取前面的数字；不是数字时返回 false
+inline bool parse_number(const std::string& value, float& out)
+{
+  const char* begin = value.c_str();
+  char* end = nullptr;
+  float v = std::strtof(begin, &end);
+  if (end == begin || !(v >= 0.f && v <= 1e6f)) return false;
+  out = v;
+  return true;
+}
+
+inline void apply_property(css_style& style, const std::string& prop,
+                           const std::string& value)
+{
+  float number = 0;
+  if (prop == "background-color")
+    style.background = css_parse_color(value);
+  else if (prop == "color")
+    style.text = css_parse_color(value);
+  else if (prop == "border-color")
+    style.border = css_parse_color(value);
+  else if (prop == "font-size" && parse_number(value, number))
+    style.font_size = static_cast<unsigned>(number);
+  else if (prop == "padding" && parse_number(value, number))
+    style.padding = number;
+  else if (prop == "border-radius" && parse_number(value, number))
+    style.border_radius = number;
+  else if (prop == "border-width" && parse_number(value, number))
+    style.border_thickness = number;
+}
+}  // namespace css_detail
+
+// 同一选择器出现多次时，后面的规则整体替换前面的，位置保持第一次出现的位置
+inline std::vector<css_rule> parse_css(std::string_view text)
+{
+  using namespace css_detail;
+  // 先去掉注释，之后的扫描不必再考虑它们
+  std::string source;
+  source.reserve(text.size());
+  for (size_t i = 0; i < text.size(); ++i)
+  {
+    if (text[i] == '/' && i + 1 < text.size() && text[i + 1] == '*')
+    {
+      size_t end = text.find("*/", i + 2);
+      if (end == std::string_view::npos) break;
+      i = end + 1;
+      continue;
+    }
+    source += text[i];
+  }
+
+  std::vector<css_rule> rules;
+  std::unordered_map<std::string, size_t> index;
+  size_t pos = 0;
+  while (true)
+  {
+    size_t open = source.find('{', pos);
+    if (open == std::string::npos) break;
+    size_t close = source.find('}', open + 1);
+    if (close == std::string::npos) break;
+
+    css_style style;
+    std::string_view body(source.data() + open + 1, close - open - 1);
+    while (!body.empty())
+    {
+      size_t semicolon = body.find(';');
+      std::string_view declaration = body.substr(0, semicolon);
+      body = semicolon == std::string_view::npos
+                 ? std::string_view()
+                 : body.substr(semicolon + 1);
+      size_t colon = declaration.find(':');
+      if (colon == std::string_view::npos) continue;
+      std::string prop = strip_spaces(declaration.substr(0, colon));
+      std::string value = strip_spaces(declaration.substr(colon + 1));
+      if (!prop.empty() && !value.empty()) apply_property(style, prop, value);
+    }
+
+    std::string selectors = strip_spaces(
+        std::string_view(source.data() + pos, open - pos));
+    size_t start = 0;
+    while (start <= selectors.size())
+    {
+      size_t comma = selectors.find(',', start);
+      if (comma == std::string::npos) comma = selectors.size();
+      std::string selector = selectors.substr(start, comma - start);
+      start = comma + 1;
+      if (selector.empty()) continue;
+      auto [it, inserted] = index.emplace(selector, rules.size());
+      if (inserted)
+        rules.push_back({selector, style});
+      else
+        rules[it->second].style = style;
+    }
+    pos = close + 1;
+  }
+  return rules;
+}
+
+// 元素的普通样式与 :hover 样式在样式表中的下标，0 表示默认样式
+struct css_style_ref
+{
+  uint32_t normal = 0;
+  uint32_t hover = 0;
+};
+
+// 依次查找 #id、.class 与标签名，悬停时同一级的 :hover 规则优先；
+// 都没有时使用默认样式。index 把选择器映射到样式表下标
+inline css_style_ref css_resolve(
+    const std::unordered_map<std::string, uint32_t>& index,
+    std::string_view tag, std::string_view id, std::string_view class_name)
+{
+  css_style_ref ref;
+  bool has_normal = false, has_hover = false;
+  std::string selectors[3] = {"#" + std::string(id),
+                              "." + std::string(class_name),
+                              std::string(tag)};
+  for (const std::string& selector : selectors)
+  {
+    if (!has_hover)
+    {
+      auto it = index.find(selector + ":hover");
+      if (it != index.end())
+      {
+        ref.hover = it->second;
+        has_hover = true;
+      }
+    }
+    auto it = index.find(selector);
+    if (it == index.end()) continue;
+    if (!has_normal)
+    {
+      ref.normal = it->second;
+      has_normal = true;
+    }
+    if (!has_hover)
+    {
+      ref.hover = it->second;
+      has_hover = true;
+    }
+  }
+  return ref;
+}
@@ -1,19 +1,40 @@
 #pragma once
 #include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <functional>
 #include <iostream>
-#include <regex>
-#include <sstream>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include <climits>
+#include <cstdint>
 #include <cstdlib>
-int windowWidth;
-int windowHeight;
-float scrollOffset = 0.f;
-float maxScrollOffset = 0.f;
+
+#include "css.h"
+// 全局状态定义在 src/div.cpp，随 libmkccrt 一起编译
+extern int windowWidth;
+extern int windowHeight;
+extern float scrollOffset;
+extern float maxScrollOffset;
 const float SCROLL_SPEED = 1.2f;
-bool isScrolling = false;
-sf::RectangleShape scrollBar;
+extern bool isScrolling;
+extern sf::RectangleShape scrollBar;
+
+// 保留式布局：每个 Div 缓存内容高度与各元素相对自身顶部的偏移，记下计算时的
+// layoutGeneration。改变布局的操作（高度变化的 setText、增删元素、样式表替换）
+// 把它加一，下一帧重新计算一次；不变的页面每帧只比较一次计数。
+// 直接修改 elements/children 之后需要调用 invalidateLayout()
+extern unsigned layoutGeneration;
+// 绘制用的顶点数组同样按 renderGeneration 缓存。只改变外观、不改变布局的操作
+// （如 Button::setText）调用 invalidateRender()
+extern unsigned renderGeneration;
+inline void invalidateRender() { ++renderGeneration; }
+inline void invalidateLayout()
+{
+  ++layoutGeneration;
+  invalidateRender();
+}
 enum class ElementType
 {
   Paragraph,
@@ -32,23 +53,69 @@ struct Style
   float borderThickness = 1.0f;
 };
 
-std::unordered_map<std::string, Style> styleSheet;
+// 样式表：styleTable[0] 是默认样式，styleIndex 把选择器映射到 styleTable 的下标。
+// 元素在创建时（或第一次取样式时）确定自己的下标，之后取样式只是一次数组访问
+using StyleRef = css_style_ref;
+const StyleRef UNRESOLVED_STYLE{UINT32_MAX, UINT32_MAX};
+extern std::vector<Style> styleTable;
+extern std::unordered_map<std::string, uint32_t> styleIndex;
+// 样式表每次改变（reset_styles、parse_css_style、load_style_table）加一
+extern unsigned styleGeneration;
+
+inline const Style &styleAt(uint32_t index)
+{
+  return index < styleTable.size() ? styleTable[index] : styleTable[0];
+}
+
+// 不对应任何样式表的 generation，持有它的句柄在第一次取样式时重新查找
+const unsigned STALE_STYLE_GENERATION = UINT_MAX;
+
+// 元素持有的样式句柄：普通与 :hover 样式的下标，以及它们所对应的样式表的
+// styleGeneration。样式表改变后句柄过期，下一次取样式时重新查找。
+// generation 由得到下标的一方显式给出：mkcc 生成的下标对应 load_style_table
+// 的返回值，运行时查找的下标对应查找时的样式表；只给出 StyleRef 的句柄是过期的
+struct StyleHandle
+{
+  StyleRef ref;
+  unsigned generation;
+
+  StyleHandle(StyleRef r = UNRESOLVED_STYLE,
+              unsigned g = STALE_STYLE_GENERATION)
+      : ref(r), generation(g)
+  {
+  }
+};
+
+// mkcc 在构建时为生成的元素算好 StyleRef；脚本或播放器创建的元素
+// 传入 UNRESOLVED_STYLE，在第一次取样式时按同样的层叠规则查找一次。
+// 样式表改变之后所有元素各自重新查找一次
+inline const Style &cachedStyle(StyleHandle &handle, const char *tag,
+                                const std::string &id,
+                                const std::string &className, bool hover)
+{
+  if (handle.ref.normal == UNRESOLVED_STYLE.normal ||
+      handle.generation != styleGeneration)
+    handle = StyleHandle(css_resolve(styleIndex, tag, id, className),
+                         styleGeneration);
+  return styleAt(hover ? handle.ref.hover : handle.ref.normal);
+}
 struct Paragraph
 {
   std::string text;
   sf::Text sfText;
-  sf::RectangleShape background;
 
   std::string id;
   std::string className;
+  mutable StyleHandle styleRef;
   float x, y;
   float width;
   float height;
 
   Paragraph(const std::string &t, const sf::Font &font,
             unsigned int passedFontSize = 16, float maxWidth = 600.f,
-            const std::string &_id = "", const std::string &_class = "")
-      : text(t), id(_id), className(_class), width(maxWidth)
+            const std::string &_id = "", const std::string &_class = "",
+            StyleHandle ref = StyleHandle())
+      : text(t), id(_id), className(_class), styleRef(ref), width(maxWidth)
   {
     Style style = getStyle();
 
@@ -61,37 +128,43 @@ struct Paragraph
     sfText.setCharacterSize(style.fontSize);
     sfText.setFillColor(style.textColor);
     sfText.setString(wrapText(t, font, style.fontSize, maxWidth));
-
-    background.setFillColor(style.backgroundColor);
+    height = measureHeight();
   }
   void setText(const std::string &newText)
   {
     text = newText;
     sfText.setString(
         wrapText(text, *sfText.getFont(), sfText.getCharacterSize(), width));
+    // 行数不变时高度不变，后面元素的位置也不变
+    float newHeight = measureHeight();
+    if (newHeight != height)
+    {
+      height = newHeight;
+      invalidateLayout();
+    }
+    else
+    {
+      invalidateRender();
+    }
   }
 
-  Style getStyle(bool hover = false) const
+  const Style &getStyle(bool hover = false) const
   {
-    std::string selector = "#" + id;
-    if (hover && styleSheet.count(selector + ":hover"))
-      return styleSheet[selector + ":hover"];
-    if (styleSheet.count(selector))
-      return styleSheet[selector];
-
-    selector = "." + className;
-    if (hover && styleSheet.count(selector + ":hover"))
-      return styleSheet[selector + ":hover"];
-    if (styleSheet.count(selector))
-      return styleSheet[selector];
-
-    selector = "p";
-    if (hover && styleSheet.count("p:hover"))
-      return styleSheet["p:hover"];
-    if (styleSheet.count("p"))
-      return styleSheet["p"];
+    return cachedStyle(styleRef, "p", id, className, hover);
+  }
 
-    return Style(); // 默认
+  // 改变 id 或 class 之后样式在下一次取用时重新查找
+  void setId(const std::string &newId)
+  {
+    id = newId;
+    styleRef = StyleHandle();
+    invalidateRender();
+  }
+  void setClassName(const std::string &newClass)
+  {
+    className = newClass;
+    styleRef = StyleHandle();
+    invalidateRender();
   }
 
   void setPosition(float px, float py)
@@ -101,22 +174,13 @@ struct Paragraph
     sfText.setPosition(px, py);
   }
 
-  void draw(sf::RenderWindow &window)
+  // 文本变化时由 setText 更新，绘制与命中测试不再测量文本
+  float getHeight() const
   {
-    Style style = getStyle(isHovered(window));
-    sfText.setFillColor(style.textColor);
-
-    // 背景框
-    height = getHeight();
-    background.setSize({width, height});
-    background.setFillColor(style.backgroundColor);
-    background.setPosition(x, y);
-
-    window.draw(background);
-    window.draw(sfText);
+    return height;
   }
 
-  float getHeight() const
+  float measureHeight() const
   {
     return sfText.getGlobalBounds().height + 10;
   }
@@ -125,7 +189,7 @@ struct Paragraph
   {
     auto mousePos = sf::Mouse::getPosition(window);
     return mousePos.x >= x && mousePos.x <= x + width && mousePos.y >= y &&
-           mousePos.y <= y + getHeight();
+           mousePos.y <= y + height;
   }
 
   static std::string wrapText(const std::string &text, const sf::Font &font,
@@ -156,18 +220,19 @@ struct Paragraph
 
 struct Button
 {
-  sf::RectangleShape rect;
   sf::Text label;
   float width = 200;
   float height = 40;
   std::string id;
   std::string className;
+  mutable StyleHandle styleRef;
   float x, y;
   std::function<void()> onClick = nullptr;
 
   Button(const std::string &text, const sf::Font &font, float px, float py,
-         const std::string &_id = "", const std::string &_class = "")
-      : id(_id), className(_class), x(px), y(py)
+         const std::string &_id = "", const std::string &_class = "",
+         StyleHandle ref = StyleHandle())
+      : id(_id), className(_class), styleRef(ref), x(px), y(py)
   {
     Style style = getStyle();
 
@@ -191,11 +256,12 @@ struct Button
       width = maxButtonWidth;
 
     height = style.fontSize + style.padding * 2;
-    rect.setSize({width, height});
   }
+  // 按钮高度只取决于字号，改变文本不影响布局
   void setText(const std::string &text)
   {
     label.setString(text);
+    invalidateRender();
 
     // 更新宽度和位置
     float textWidth = label.getLocalBounds().width;
@@ -233,27 +299,23 @@ struct Button
     }
   }
 
-  Style getStyle(bool hover = false) const
+  const Style &getStyle(bool hover = false) const
   {
-    std::string selector = "#" + id;
-    if (hover && styleSheet.count(selector + ":hover"))
-      return styleSheet[selector + ":hover"];
-    if (styleSheet.count(selector))
-      return styleSheet[selector];
-
-    selector = "." + className;
-    if (hover && styleSheet.count(selector + ":hover"))
-      return styleSheet[selector + ":hover"];
-    if (styleSheet.count(selector))
-      return styleSheet[selector];
-
-    selector = "button";
-    if (hover && styleSheet.count("button:hover"))
-      return styleSheet["button:hover"];
-    if (styleSheet.count("button"))
-      return styleSheet["button"];
+    return cachedStyle(styleRef, "button", id, className, hover);
+  }
 
-    return Style(); // 默认
+  // 改变 id 或 class 之后样式在下一次取用时重新查找
+  void setId(const std::string &newId)
+  {
+    id = newId;
+    styleRef = StyleHandle();
+    invalidateRender();
+  }
+  void setClassName(const std::string &newClass)
+  {
+    className = newClass;
+    styleRef = StyleHandle();
+    invalidateRender();
   }
   void setPosition(float px, float py)
   {
@@ -261,29 +323,6 @@ struct Button
     y = py;
   }
 
-  void draw(sf::RenderWindow &window)
-  {
-    bool hover = isHovered(window);
-    Style style = getStyle(hover);
-
-    rect.setSize({width, height});
-    rect.setPosition(x, y);
-    rect.setFillColor(style.backgroundColor);
-    rect.setOutlineColor(style.borderColor);
-    rect.setOutlineThickness(style.borderThickness);
-
-    label.setCharacterSize(style.fontSize);
-    label.setFillColor(style.textColor);
-
-    sf::FloatRect textBounds = label.getLocalBounds();
-    float textX = x + (width - textBounds.width) / 2.f - textBounds.left;
-    float textY = y + (height - textBounds.height) / 2.f - textBounds.top;
-    label.setPosition(textX, textY);
-
-    window.draw(rect);
-    window.draw(label);
-  }
-
   bool isHovered(const sf::RenderWindow &window) const
   {
     auto mousePos = sf::Mouse::getPosition(window);
@@ -365,6 +404,94 @@ struct Element
   Element &operator=(const Element &) = delete;
 };
 
+struct Div;
+
+// 把一棵 Div 树画成少量顶点数组：所有纯色矩形（背景与按钮边框）放在一个数组里，
+// 文字按字形纹理（同一字体的同一字号）分组，各一个数组，每帧只有几次 draw 调用。
+// 顶点按未滚动的位置生成，滚动只改变绘制时的平移；renderGeneration 变化时
+// 整体重建，悬停状态变化时只改写相应元素的顶点颜色。
+// 文字画在所有矩形之上；子 Div 与根 Div 共用一个视图和滚动量。
+//
+// 元素按先序排列，纵向位置单调，因此窗口内的元素是一段连续的下标，
+// 用二分查找得到；绘制、悬停判断与滚动后的位置更新都只处理这一段
+class RenderBatch
+{
+public:
+  void draw(Div &root, sf::RenderWindow &window);
+  // 把事件分发给可见的按钮。页面在上次绘制之后改变过时返回 false，
+  // 由调用方遍历整棵树
+  bool handleEvent(const sf::Event &event, const sf::RenderWindow &window);
+
+private:
+  enum class Kind
+  {
+    Paragraph,
+    Button
+  };
+
+  // 一个段落或按钮在顶点数组中的位置
+  struct Item
+  {
+    Kind kind;
+    void *element;
+    float x, y;        // 未滚动的位置
+    float top, bottom; // 顶点覆盖的纵向范围（含边框与字形）
+    bool hovered;
+    size_t rectFirst, rectCount; // 填充 6 个顶点，之后是边框
+    size_t layer, textFirst, textCount;
+  };
+
+  // divs[i] 的背景是 divRects 中第 6i 个顶点起的 6 个顶点
+  struct DivItem
+  {
+    Div *div;
+    float x, y, bottom;
+    size_t parent; // 父 div 在 divs 中的下标，根为 NO_PARENT
+    bool hovered;
+  };
+  static const size_t NO_PARENT = SIZE_MAX;
+
+  struct TextLayer
+  {
+    const sf::Font *font;
+    unsigned characterSize;
+    sf::VertexArray vertices{sf::Triangles};
+    std::vector<size_t> runs; // 在这一层有文字的元素下标，递增
+    size_t first = 0, count = 0; // 当前可见的顶点
+  };
+
+  void rebuild(Div &root, const sf::RenderWindow &window);
+  void addDiv(Div &div, float x, float y, size_t parent,
+              const sf::RenderWindow &window);
+  void addRect(float x, float y, float width, float height, sf::Color color);
+  void addText(Item &item, const sf::Text &text, float x, float y,
+               sf::Color color);
+  void cull();
+  void moveVisible();
+  bool updateHover(const sf::RenderWindow &window);
+  bool paint(Item &item, bool hovered);
+  void paintDiv(DivItem &item, bool hovered);
+  void recolorText(const Item &item, sf::Color color);
+
+  sf::VertexArray divRects{sf::Triangles};
+  sf::VertexArray rects{sf::Triangles};
+  std::vector<TextLayer> layers;
+  std::vector<Item> items;
+  std::vector<DivItem> divs;
+  std::vector<float> maxBottom; // items[0..i] 的 bottom 的最大值，单调不减
+  std::vector<float> minTop;    // items[i..] 的 top 的最小值，单调不减
+  unsigned stamp = 0;           // 生成顶点时的 renderGeneration
+  float placedScroll = 0.f;
+  sf::Vector2i mouse;
+  Button *pressed = nullptr; // 最近一次被按下的按钮，松开时复位
+
+  // cull() 的结果：可见的元素 [visibleFirst, visibleLast)，可见的 div 是
+  // divChain（跨过窗口顶边的祖先）加上 [divFirst, divLast)
+  size_t visibleFirst = 0, visibleLast = 0;
+  std::vector<size_t> divChain;
+  size_t divFirst = 0, divLast = 0;
+};
+
 // 简单容器元素
 struct Div
 {
@@ -372,6 +499,7 @@ struct Div
 
   std::string id;
   std::string className;
+  mutable StyleHandle styleRef;
 
   std::vector<Div> children; // 允许嵌套 Div
   float x, y;
@@ -379,31 +507,45 @@ struct Div
   float scrollDragStartY = 0.f;      // 添加这个成员变量
   float scrollDragStartOffset = 0.f; // 添加这个成员变量
 
+  // 缓存的布局，layoutStamp 与 layoutGeneration 不同时由 updateLayout 重新计算
+  mutable unsigned layoutStamp = 0;
+  mutable float contentHeight = 0.f;
+  mutable std::vector<float> elementOffsets; // elements[i] 相对 div 顶部的偏移
+  mutable std::vector<float> childOffsets;   // children[i] 相对 div 顶部的偏移
+
+  std::unique_ptr<RenderBatch> batch; // 作为根节点绘制时创建
+
   Div(float px, float py, const std::string &_id = "",
-      const std::string &_class = "")
-      : x(px), y(py), id(_id), className(_class)
+      const std::string &_class = "", StyleHandle ref = StyleHandle())
+      : x(px), y(py), id(_id), className(_class), styleRef(ref)
   {
     maxWidth = windowWidth - 2 * px;
   }
 
   void addParagraph(const std::string &text, const sf::Font &font,
                     unsigned fontSize = 16, const std::string &id = "",
-                    const std::string &className = "")
+                    const std::string &className = "",
+                    StyleHandle style = StyleHandle())
   {
-    Paragraph *p = new Paragraph(text, font, fontSize, maxWidth, id, className);
+    Paragraph *p =
+        new Paragraph(text, font, fontSize, maxWidth, id, className, style);
     elements.emplace_back(p);
+    invalidateLayout();
   }
 
   void addButton(const std::string &text, const sf::Font &font,
-                 const std::string &id = "", const std::string &className = "")
+                 const std::string &id = "", const std::string &className = "",
+                 StyleHandle style = StyleHandle())
   {
-    Button *b = new Button(text, font, 0, 0, id, className);
+    Button *b = new Button(text, font, 0, 0, id, className, style);
     elements.emplace_back(b);
+    invalidateLayout();
   }
 
   void addChild(Div &&child)
   {
     children.push_back(std::move(child));
+    invalidateLayout();
   }
   Element *getElementById(const std::string &searchId)
   {
@@ -422,55 +564,15 @@ struct Div
 
     return nullptr;
   }
+  // 以这个 div 为根绘制整棵树，见 RenderBatch
   void draw(sf::RenderWindow &window)
   {
-    // 创建视图(viewport)来实现滚动效果
-    sf::View view = window.getDefaultView();
-    sf::FloatRect visibleArea(x, y, maxWidth, windowHeight - y); // 移除了scrollOffset
-    view.setViewport(sf::FloatRect(0, 0, 1, 1));
-    view.reset(visibleArea);
-    window.setView(view);
-
-    float currentY = y - scrollOffset; // 改为在这里应用滚动偏移
-
-    Style style = getStyle(isHovered(window));
-
-    sf::RectangleShape bg;
-    float totalHeight = getTotalHeight();
-    bg.setPosition(x, currentY); // 使用调整后的currentY
-    bg.setSize({maxWidth, totalHeight});
-    bg.setFillColor(style.backgroundColor);
-    window.draw(bg);
-
-    for (auto &elem : elements)
-    {
-      if (elem.type == ElementType::Paragraph)
-      {
-        elem.paragraph->setPosition(x, currentY);
-        elem.paragraph->draw(window);
-        currentY += elem.paragraph->getHeight();
-      }
-      else if (elem.type == ElementType::Button)
-      {
-        elem.button->setPosition(x, currentY);
-        elem.button->draw(window);
-        currentY += elem.button->getHeight();
-      }
-    }
-
-    for (auto &child : children)
-    {
-      child.x = x + 10;
-      child.y = currentY;
-      child.draw(window);
-      currentY += child.getTotalHeight();
-    }
-
-    // 恢复默认视图
-    window.setView(window.getDefaultView());
+    if (!batch)
+      batch = std::make_unique<RenderBatch>();
+    batch->draw(*this, window);
 
     // 绘制滚动条
-    drawScrollBar(window, totalHeight);
+    drawScrollBar(window, contentHeight);
   }
 
   void drawScrollBar(sf::RenderWindow &window, float totalHeight)
@@ -504,47 +606,65 @@ struct Div
     window.draw(scrollBar);
   }
 
-  float getTotalHeight() const
+  // 布局过期时自下而上重新计算偏移与内容高度，否则什么也不做
+  void updateLayout() const
   {
+    if (layoutStamp == layoutGeneration)
+      return;
+
     float h = 0;
-    for (const auto &elem : elements)
+    elementOffsets.resize(elements.size());
+    for (size_t i = 0; i < elements.size(); ++i)
     {
+      elementOffsets[i] = h;
+      const Element &elem = elements[i];
       if (elem.type == ElementType::Paragraph)
         h += elem.paragraph->getHeight();
       else if (elem.type == ElementType::Button)
         h += elem.button->getHeight();
     }
 
-    for (const auto &div : children)
-      h += div.getTotalHeight();
+    childOffsets.resize(children.size());
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+      childOffsets[i] = h;
+      h += children[i].getTotalHeight();
+    }
 
-    return h;
+    contentHeight = h;
+    layoutStamp = layoutGeneration;
   }
 
-  Style getStyle(bool hover = false) const
+  float getTotalHeight() const
   {
-    std::string selector = "#" + id;
-    if (hover && styleSheet.count(selector + ":hover"))
-      return styleSheet[selector + ":hover"];
-    if (styleSheet.count(selector))
-      return styleSheet[selector];
-
-    selector = "." + className;
-    if (hover && styleSheet.count(selector + ":hover"))
-      return styleSheet[selector + ":hover"];
-    if (styleSheet.count(selector))
-      return styleSheet[selector];
+    updateLayout();
+    return contentHeight;
+  }
 
-    selector = "div";
-    if (hover && styleSheet.count("div:hover"))
-      return styleSheet["div:hover"];
-    if (styleSheet.count("div"))
-      return styleSheet["div"];
+  const Style &getStyle(bool hover = false) const
+  {
+    return cachedStyle(styleRef, "div", id, className, hover);
+  }
 
-    return Style(); // 默认样式
+  // 改变 id 或 class 之后样式在下一次取用时重新查找
+  void setId(const std::string &newId)
+  {
+    id = newId;
+    styleRef = StyleHandle();
+    invalidateRender();
+  }
+  void setClassName(const std::string &newClass)
+  {
+    className = newClass;
+    styleRef = StyleHandle();
+    invalidateRender();
   }
   void handleEvent(const sf::Event &event, const sf::RenderWindow &window)
   {
+    // 作为根节点绘制过时只检查窗口内的按钮，与悬停判断相同
+    if (batch && batch->handleEvent(event, window))
+      return;
+
     for (auto &elem : elements)
     {
       if (elem.type == ElementType::Button)
@@ -623,99 +743,13 @@ struct Div
   }
 };
 
-sf::Color parse_css_color(const std::string &val)
-{
-  if (val == "red")
-    return sf::Color::Red;
-  if (val == "green")
-    return sf::Color::Green;
-  if (val == "blue")
-    return sf::Color::Blue;
-  if (val == "black")
-    return sf::Color::Black;
-  if (val == "white")
-    return sf::Color::White;
-  if (val == "gray")
-    return sf::Color(128, 128, 128);
-  if (val == "yellow")
-    return sf::Color::Yellow;
-
-  // 支持 #RRGGBB 十六进制格式
-  if (val.size() == 7 && val[0] == '#')
-  {
-    int r, g, b;
-    std::stringstream ss;
-    ss << std::hex << val.substr(1, 2);
-    ss >> r;
-    ss.clear();
-    ss << std::hex << val.substr(3, 2);
-    ss >> g;
-    ss.clear();
-    ss << std::hex << val.substr(5, 2);
-    ss >> b;
-    return sf::Color(r, g, b);
-  }
-
-  return sf::Color::White; // 默认
-}
-// 解析 CSS 文本并填充 styleSheet
-void parse_css_style(const std::string &cssText)
-{
-  std::regex blockRegex(R"(([^\{]+)\{([^}]+)\})");
-  std::regex propRegex(R"(([^:]+):([^;]+);?)");
-
-  auto blocksBegin =
-      std::sregex_iterator(cssText.begin(), cssText.end(), blockRegex);
-  auto blocksEnd = std::sregex_iterator();
-
-  for (auto i = blocksBegin; i != blocksEnd; ++i)
-  {
-    std::string selector =
-        std::regex_replace((*i)[1].str(), std::regex(R"(\s+)"), "");
-    std::string body = (*i)[2].str();
-
-    Style style;
-
-    auto propsBegin = std::sregex_iterator(body.begin(), body.end(), propRegex);
-    auto propsEnd = std::sregex_iterator();
-
-    for (auto j = propsBegin; j != propsEnd; ++j)
-    {
-      std::string prop =
-          std::regex_replace((*j)[1].str(), std::regex(R"(\s+)"), "");
-      std::string val =
-          std::regex_replace((*j)[2].str(), std::regex(R"(\s+)"), "");
-
-      if (prop == "background-color")
-      {
-        style.backgroundColor = parse_css_color(val);
-      }
-      else if (prop == "color")
-      {
-        style.textColor = parse_css_color(val);
-      }
-      else if (prop == "font-size")
-      {
-        style.fontSize = std::stoi(val);
-      }
-      else if (prop == "padding")
-      {
-        style.padding = std::stof(val);
-      }
-      else if (prop == "border-radius")
-      {
-        style.borderRadius = std::stof(val);
-      }
-      else if (prop == "border-color")
-      {
-        style.borderColor = parse_css_color(val);
-      }
-      else if (prop == "border-width")
-      {
-        style.borderThickness = std::stof(val);
-      }
-    }
-
-    styleSheet[selector] = style;
-  }
-}
+sf::Color parse_css_color(const std::string &val);
+// 清空样式表，只留下默认样式。以下三个函数都会让所有元素的样式句柄过期
+void reset_styles();
+// 解析 CSS 文本并加入样式表
+void parse_css_style(const std::string &cssText);
+// 用 mkcc 在构建时解析好的样式表替换当前样式表，selectors[i] 对应
+// styleTable[i + 1]，与生成代码中各元素的 StyleRef 一致。返回新样式表的
+// styleGeneration，生成代码用它构造这些 StyleRef 的句柄
+unsigned load_style_table(const char *const *selectors, const Style *styles,
+                          size_t count);
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+
+#include "div.h"
+#include "ui_desc.h"
+
+// 热重载：mkcc watch 通过环境变量 MKCC_RELOAD_PIPE / MKCC_RELOAD_UI 告诉程序
+// 一个命名管道和 .mkui 文件的路径。管道里每收到数据，就重新加载 UI 描述。
+// 没有设置环境变量（或不是 POSIX 平台）时什么都不做
+struct LiveReload
+{
+  int fd = -1;
+  std::string uiPath;
+
+  LiveReload();
+  ~LiveReload();
+  LiveReload(const LiveReload &) = delete;
+  LiveReload &operator=(const LiveReload &) = delete;
+
+  bool enabled() const { return fd >= 0; }
+
+  // 非阻塞检查管道，有新的描述时加载到 doc 并返回 true
+  bool poll(ui_document &doc);
+};
+
+// 清空 root 并按新的描述重建元素树与样式表
+void reload_ui(Div &root, const ui_document &doc, const sf::Font &font);
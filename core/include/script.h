@@ -0,0 +1,29 @@
+#pragma once
+#include <memory>
+
+#include "div.h"
+
+// 所有 <script> 生成的类都继承自 script，每个脚本编译为独立的翻译单元
+class script{
+public:
+    Div *root;
+    script(Div & rootnode){
+        root=&rootnode;on_load();
+}
+    virtual ~script(){
+        on_unload();
+    }
+    virtual void on_load(){
+
+    }
+    virtual void on_unload(){
+
+    }
+};
+
+template<typename T>
+std::unique_ptr<T> create_script(Div& root) {
+    auto s = std::make_unique<T>(root);
+    s->on_load();
+    return s;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "div.h"
+#include "ui_desc.h"
+
+// 按元素表实例化区间 range 内的元素并加入 root。编译模式的程序传入 mkcc
+// 生成的静态数组，播放器传入 .mkui 中读出的数组。strings 为字符串池，
+// components 为 UI_COMPONENT 引用的组件区间（可以为空），区间都是相对
+// elements 起点的下标。generation 是元素表中样式下标所对应的样式表的
+// styleGeneration（load_style_table 的返回值）
+void build_ui_table(Div &root, const ui_element *elements, ui_range range,
+                    const char *strings, const ui_range *components,
+                    const sf::Font &font, unsigned generation);
+
+// 按 UI 描述实例化元素树并加载样式表，播放器与热重载共用
+void build_ui(Div &root, const ui_document &doc, const sf::Font &font);
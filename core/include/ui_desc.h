@@ -0,0 +1,269 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// 紧凑的二进制 UI 描述（.mkui），由 mkcc 从 MKML 生成，播放器在启动时加载。
+// 只依赖标准库，编译器与运行时共用。文件布局（整数为本机字节序）：
+//
+//   "MKUI" u32:version
+//   u32:strings_size   bytes...           所有文本共用的字符串池
+//   u32:head_count     ui_head[]          <head> 中的宏，如 title、size_x
+//   ui_str:css                            合并后的样式表文本
+//   u32:element_count  ui_element[]       各区间内按文档顺序，父节点总在子节点之前
+//   ui_range:body                         <body> 的元素区间
+//   u32:component_count ui_range[]        各组件的元素区间，被依赖的组件在前
+//
+// 编译模式的程序把同样的元素表生成为 main.cpp 中的静态数组，两者由同一个
+// build_ui_table 实例化
+
+const uint32_t UI_DESC_VERSION = 2;
+
+enum ui_element_type : uint32_t
+{
+  UI_DIV = 0,
+  UI_PARAGRAPH = 1,
+  UI_BUTTON = 2,
+  UI_COMPONENT = 3  // 在父 div 中展开 components[component] 区间的元素
+};
+
+struct ui_str
+{
+  uint32_t offset = 0;
+  uint32_t length = 0;
+};
+
+struct ui_head
+{
+  ui_str key;
+  ui_str value;
+};
+
+struct ui_element
+{
+  uint32_t type = UI_PARAGRAPH;
+  int32_t parent = -1;  // 所属 div 相对区间起点的下标，-1 表示区间展开到的 div
+  uint32_t font_size = 16;
+  ui_str text;
+  ui_str id;
+  ui_str class_name;
+  uint32_t style = 0;        // 构建时解析好的样式表下标，0 为默认样式
+  uint32_t hover_style = 0;
+  uint32_t component = 0;    // UI_COMPONENT 使用
+};
+
+// 元素表中的一段连续元素 [first, first + count)
+struct ui_range
+{
+  uint32_t first = 0;
+  uint32_t count = 0;
+};
+
+struct ui_document
+{
+  std::string strings;
+  std::vector<ui_head> heads;
+  ui_str css;
+  std::vector<ui_element> elements;
+  ui_range body;
+  std::vector<ui_range> components;
+
+  std::string_view str(ui_str s) const
+  {
+    return std::string_view(strings).substr(s.offset, s.length);
+  }
+
+  std::string head(std::string_view key, const std::string& fallback) const
+  {
+    for (const auto& h : heads)
+    {
+      if (str(h.key) == key) return std::string(str(h.value));
+    }
+    return fallback;
+  }
+};
+
+// 构建 ui_document 时使用。add 查重，相同的 id、class 名等短字符串只在池中存
+// 一份；索引只保存池内的偏移与长度，新字符串先追加到池尾再查重，重复时截掉，
+// 不为键另外分配内存。元素文本与样式表几乎不会重复，用 append 直接追加，
+// 不进索引，也不为它们计算哈希
+struct ui_string_pool
+{
+  struct key_hash
+  {
+    const std::string* strings;
+    size_t operator()(ui_str s) const
+    {
+      return std::hash<std::string_view>()(
+          std::string_view(*strings).substr(s.offset, s.length));
+    }
+  };
+  struct key_equal
+  {
+    const std::string* strings;
+    bool operator()(ui_str a, ui_str b) const
+    {
+      return a.length == b.length &&
+             strings->compare(a.offset, a.length, *strings, b.offset,
+                              b.length) == 0;
+    }
+  };
+
+  std::string& strings;
+  std::unordered_set<ui_str, key_hash, key_equal> index;
+
+  explicit ui_string_pool(std::string& s)
+      : strings(s), index(16, key_hash{&s}, key_equal{&s})
+  {
+  }
+
+  // 直接追加到池尾，不查重
+  ui_str append(std::string_view text)
+  {
+    if (text.empty()) return {};
+    ui_str s{static_cast<uint32_t>(strings.size()),
+             static_cast<uint32_t>(text.size())};
+    strings.append(text);
+    return s;
+  }
+
+  ui_str add(std::string_view text)
+  {
+    if (text.empty()) return {};
+    ui_str s{static_cast<uint32_t>(strings.size()),
+             static_cast<uint32_t>(text.size())};
+    strings.append(text);
+    auto [it, inserted] = index.insert(s);
+    if (!inserted) strings.resize(s.offset);
+    return *it;
+  }
+};
+
+inline void ui_write_u32(std::string& out, uint32_t v)
+{
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+template <typename T>
+inline void ui_write_array(std::string& out, const std::vector<T>& items)
+{
+  ui_write_u32(out, static_cast<uint32_t>(items.size()));
+  if (!items.empty())
+  {
+    out.append(reinterpret_cast<const char*>(items.data()),
+               items.size() * sizeof(T));
+  }
+}
+
+inline std::string serialize_ui_document(const ui_document& doc)
+{
+  std::string out = "MKUI";
+  ui_write_u32(out, UI_DESC_VERSION);
+  ui_write_u32(out, static_cast<uint32_t>(doc.strings.size()));
+  out += doc.strings;
+  ui_write_array(out, doc.heads);
+  out.append(reinterpret_cast<const char*>(&doc.css), sizeof(doc.css));
+  ui_write_array(out, doc.elements);
+  out.append(reinterpret_cast<const char*>(&doc.body), sizeof(doc.body));
+  ui_write_array(out, doc.components);
+  return out;
+}
+
+// 按顺序读取，越界时返回 false
+struct ui_reader
+{
+  std::string_view data;
+  size_t pos = 0;
+
+  bool read(void* dst, size_t size)
+  {
+    if (pos + size > data.size()) return false;
+    std::memcpy(dst, data.data() + pos, size);
+    pos += size;
+    return true;
+  }
+
+  template <typename T>
+  bool read_array(std::vector<T>& items)
+  {
+    uint32_t count = 0;
+    if (!read(&count, sizeof(count))) return false;
+    if (count > (data.size() - pos) / sizeof(T)) return false;
+    items.resize(count);
+    return count == 0 || read(items.data(), count * sizeof(T));
+  }
+};
+
+inline bool ui_str_valid(const ui_document& doc, ui_str s)
+{
+  return s.offset <= doc.strings.size() &&
+         s.length <= doc.strings.size() - s.offset;
+}
+
+// 区间内的父节点必须是区间内更早的 div；组件只能引用下标更小的组件，
+// 这样展开不会形成循环。limit 为可引用的组件数
+inline bool ui_range_valid(const ui_document& doc, ui_range r, size_t limit)
+{
+  if (r.first > doc.elements.size() || r.count > doc.elements.size() - r.first)
+    return false;
+  for (uint32_t i = 0; i < r.count; ++i)
+  {
+    const auto& e = doc.elements[r.first + i];
+    if (e.parent < -1 || e.parent >= static_cast<int32_t>(i) ||
+        (e.parent >= 0 && doc.elements[r.first + e.parent].type != UI_DIV))
+      return false;
+    if (e.type == UI_COMPONENT && e.component >= limit) return false;
+  }
+  return true;
+}
+
+inline bool deserialize_ui_document(std::string_view data, ui_document& doc)
+{
+  ui_reader in{data};
+  char magic[4];
+  uint32_t version = 0, strings_size = 0;
+  if (!in.read(magic, 4) || std::memcmp(magic, "MKUI", 4) != 0) return false;
+  if (!in.read(&version, 4) || version != UI_DESC_VERSION) return false;
+  if (!in.read(&strings_size, 4) || strings_size > data.size() - in.pos)
+    return false;
+
+  doc.strings.assign(data.data() + in.pos, strings_size);
+  in.pos += strings_size;
+  if (!in.read_array(doc.heads) || !in.read(&doc.css, sizeof(doc.css)) ||
+      !in.read_array(doc.elements) || !in.read(&doc.body, sizeof(doc.body)) ||
+      !in.read_array(doc.components))
+    return false;
+
+  // 校验所有引用，损坏的文件不会导致越界访问
+  if (!ui_str_valid(doc, doc.css)) return false;
+  for (const auto& h : doc.heads)
+  {
+    if (!ui_str_valid(doc, h.key) || !ui_str_valid(doc, h.value)) return false;
+  }
+  for (const auto& e : doc.elements)
+  {
+    if (!ui_str_valid(doc, e.text) || !ui_str_valid(doc, e.id) ||
+        !ui_str_valid(doc, e.class_name))
+      return false;
+  }
+  if (!ui_range_valid(doc, doc.body, doc.components.size())) return false;
+  for (size_t i = 0; i < doc.components.size(); ++i)
+  {
+    if (!ui_range_valid(doc, doc.components[i], i)) return false;
+  }
+  return true;
+}
+
+inline bool load_ui_document(const std::string& path, ui_document& doc)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  std::ostringstream ss;
+  ss << file.rdbuf();
+  return deserialize_ui_document(ss.str(), doc);
+}
@@ -1,5 +1,8 @@
 #include "include/div.h"
 #include "include/font.h"
+#include "include/script.h"
+#include "include/live_reload.h"
+#include "include/ui_build.h"
 
 /*start*/
 
@@ -14,32 +17,6 @@
 #define MKMLsize_y "600"
 #endif
 /*back_end*/
-template<typename T>
-std::unique_ptr<T> create_script(Div& root) {
-    auto s = std::make_unique<T>(root);
-    s->on_load();
-    return s;
-}
-
-
-class script{
-public:
-    Div *root;
-    script(Div & rootnode){
-        root=&rootnode;on_load();
-}
-    ~script(){
-        on_unload();
-    }
-    virtual void on_load(){
-
-    }
-    virtual void on_unload(){
-
-    }
-};
-
-
 /*script*/
 
 
@@ -52,14 +29,28 @@ int str_to_int(const std::string& str) {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    std::string title = MKMLtitle;
+    std::string size_x = MKMLsize_x;
+    std::string size_y = MKMLsize_y;
+#ifdef MKCC_PLAYER
+    // 播放器模式：界面来自 mkcc 生成的 .mkui 描述文件，不需要编译 MKML
+    ui_document document;
+    if (argc < 2 || !load_ui_document(argv[1], document)) {
+        std::cerr << "Usage: mkcc_player <file.mkui> (missing or invalid UI description)" << std::endl;
+        return 1;
+    }
+    title = document.head("title", title);
+    size_x = document.head("size_x", size_x);
+    size_y = document.head("size_y", size_y);
+#endif
     sf::RenderWindow window(
-    sf::VideoMode(str_to_int(MKMLsize_x), str_to_int(MKMLsize_y)),
-    MKMLtitle,
+    sf::VideoMode(str_to_int(size_x), str_to_int(size_y)),
+    title,
     sf::Style::Titlebar | sf::Style::Close // 禁止拉伸，保留标题栏和关闭按钮
 );
-    windowWidth = str_to_int(MKMLsize_x);
-    windowHeight = str_to_int(MKMLsize_y);
+    windowWidth = str_to_int(size_x);
+    windowHeight = str_to_int(size_y);
     // 加载字体（SFML 需要）
     sf::Font font;
     std::string fontPath = getSystemFontPath("Arial");
@@ -76,14 +67,28 @@ int main() {
 
     // 创建 div
     Div rootdiv(2, 2);
-    
+#ifdef MKCC_PLAYER
+    build_ui(rootdiv, document, font);
+#endif
     
 /*body_start*/
 
 
 /*scripts_start*/
 
+    // mkcc watch 启动时才生效：标记或样式变化后直接在当前窗口重建界面
+    LiveReload live_reload;
+    ui_document reloaded;
     while (window.isOpen()) {
+        if (live_reload.poll(reloaded)) {
+            for (auto& s : scripts_list) {
+                if (s) s->on_unload();
+            }
+            reload_ui(rootdiv, reloaded, font);
+            for (auto& s : scripts_list) {
+                if (s) s->on_load();
+            }
+        }
         sf::Event event;
         while (window.pollEvent(event)) {
             if (event.type == sf::Event::Closed)
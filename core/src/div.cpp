@@ -0,0 +1,75 @@
+#include "div.h"
+
+#include "css.h"
+
+int windowWidth;
+int windowHeight;
+float scrollOffset = 0.f;
+float maxScrollOffset = 0.f;
+bool isScrolling = false;
+sf::RectangleShape scrollBar;
+unsigned layoutGeneration = 1; // 新建的 Div 的 layoutStamp 为 0，第一次绘制时计算
+
+std::vector<Style> styleTable(1);
+std::unordered_map<std::string, uint32_t> styleIndex;
+unsigned styleGeneration = 0;
+
+static sf::Color to_sf_color(const css_color &c)
+{
+  return sf::Color(c.r, c.g, c.b, c.a);
+}
+
+static Style to_style(const css_style &s)
+{
+  Style style;
+  style.backgroundColor = to_sf_color(s.background);
+  style.textColor = to_sf_color(s.text);
+  style.fontSize = s.font_size;
+  style.padding = s.padding;
+  style.borderRadius = s.border_radius;
+  style.borderColor = to_sf_color(s.border);
+  style.borderThickness = s.border_thickness;
+  return style;
+}
+
+sf::Color parse_css_color(const std::string &val)
+{
+  return to_sf_color(css_parse_color(val));
+}
+void reset_styles()
+{
+  styleTable.assign(1, Style());
+  styleIndex.clear();
+  ++styleGeneration;
+  invalidateLayout();
+}
+
+// 编译模式的程序使用 mkcc 生成的样式表，只有播放器与热重载需要在运行时解析。
+// 已有的选择器原地替换，下标不变
+void parse_css_style(const std::string &cssText)
+{
+  for (const css_rule &rule : parse_css(cssText))
+  {
+    auto [it, inserted] = styleIndex.emplace(
+        rule.selector, static_cast<uint32_t>(styleTable.size()));
+    if (inserted)
+      styleTable.push_back(to_style(rule.style));
+    else
+      styleTable[it->second] = to_style(rule.style);
+  }
+  ++styleGeneration;
+  invalidateLayout();
+}
+
+unsigned load_style_table(const char *const *selectors, const Style *styles,
+                          size_t count)
+{
+  reset_styles();
+  styleTable.insert(styleTable.end(), styles, styles + count);
+  styleIndex.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+  {
+    styleIndex.emplace(selectors[i], static_cast<uint32_t>(i + 1));
+  }
+  return styleGeneration;
+}
@@ -0,0 +1,70 @@
+#include "live_reload.h"
+
+#include <cstdlib>
+
+#include "ui_build.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+LiveReload::LiveReload()
+{
+#ifndef _WIN32
+  const char *pipe = std::getenv("MKCC_RELOAD_PIPE");
+  const char *ui = std::getenv("MKCC_RELOAD_UI");
+  if (!pipe || !ui)
+    return;
+
+  // 以非阻塞方式打开读端，没有写端时 open 也会立即返回
+  fd = open(pipe, O_RDONLY | O_NONBLOCK);
+  uiPath = ui;
+#endif
+}
+
+LiveReload::~LiveReload()
+{
+#ifndef _WIN32
+  if (fd >= 0)
+    close(fd);
+#endif
+}
+
+bool LiveReload::poll(ui_document &doc)
+{
+#ifndef _WIN32
+  if (fd < 0)
+    return false;
+
+  // 一次读空管道，多次连续的通知只重载一次
+  bool notified = false;
+  char buffer[64];
+  while (read(fd, buffer, sizeof(buffer)) > 0)
+    notified = true;
+  if (!notified)
+    return false;
+
+  ui_document next;
+  if (!load_ui_document(uiPath, next))
+  {
+    std::cerr << "[mkcc] Live reload: invalid UI description " << uiPath
+              << std::endl;
+    return false;
+  }
+  doc = std::move(next);
+  return true;
+#else
+  (void)doc;
+  return false;
+#endif
+}
+
+void reload_ui(Div &root, const ui_document &doc, const sf::Font &font)
+{
+  root.elements.clear();
+  root.children.clear();
+  invalidateLayout();
+  scrollOffset = 0.f;
+  build_ui(root, doc, font);
+}
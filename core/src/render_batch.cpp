@@ -0,0 +1,481 @@
+#include "div.h"
+
+unsigned renderGeneration = 1; // RenderBatch::stamp 从 0 开始，第一次绘制时生成
+
+// 与 sf::Text 相同的排版（SFML 2.5 的 Text::ensureGeometryUpdate），
+// 只是顶点直接写入共享的数组，并且已经加上了文字的位置
+static void appendGlyphs(sf::VertexArray &out, const sf::Font &font,
+                         unsigned size, const sf::String &string, float x0,
+                         float y0, sf::Color color)
+{
+  const float padding = 1.f;
+  float whitespace = font.getGlyph(L' ', size, false).advance;
+  float lineSpacing = font.getLineSpacing(size);
+  float x = 0.f;
+  float y = static_cast<float>(size);
+
+  sf::Uint32 prev = 0;
+  for (std::size_t i = 0; i < string.getSize(); ++i)
+  {
+    sf::Uint32 c = string[i];
+    if (c == L'\r')
+      continue;
+    x += font.getKerning(prev, c, size);
+    prev = c;
+
+    if (c == L' ')
+    {
+      x += whitespace;
+      continue;
+    }
+    if (c == L'\t')
+    {
+      x += whitespace * 4;
+      continue;
+    }
+    if (c == L'\n')
+    {
+      y += lineSpacing;
+      x = 0.f;
+      continue;
+    }
+
+    const sf::Glyph &glyph = font.getGlyph(c, size, false);
+    float left = x0 + x + glyph.bounds.left - padding;
+    float top = y0 + y + glyph.bounds.top - padding;
+    float right = left + glyph.bounds.width + padding * 2;
+    float bottom = top + glyph.bounds.height + padding * 2;
+    float u1 = glyph.textureRect.left - padding;
+    float v1 = glyph.textureRect.top - padding;
+    float u2 = glyph.textureRect.left + glyph.textureRect.width + padding;
+    float v2 = glyph.textureRect.top + glyph.textureRect.height + padding;
+
+    out.append(sf::Vertex({left, top}, color, {u1, v1}));
+    out.append(sf::Vertex({right, top}, color, {u2, v1}));
+    out.append(sf::Vertex({left, bottom}, color, {u1, v2}));
+    out.append(sf::Vertex({left, bottom}, color, {u1, v2}));
+    out.append(sf::Vertex({right, top}, color, {u2, v1}));
+    out.append(sf::Vertex({right, bottom}, color, {u2, v2}));
+
+    x += glyph.advance;
+  }
+}
+
+static void recolor(sf::VertexArray &vertices, size_t first, size_t count,
+                    sf::Color color)
+{
+  for (size_t i = first; i < first + count; ++i)
+    vertices[i].color = color;
+}
+
+// 把顶点的纵向范围并入 [top, bottom]
+static void extend(const sf::VertexArray &vertices, size_t first, size_t count,
+                   float &top, float &bottom)
+{
+  for (size_t i = first; i < first + count; ++i)
+  {
+    top = std::min(top, vertices[i].position.y);
+    bottom = std::max(bottom, vertices[i].position.y);
+  }
+}
+
+void RenderBatch::addRect(float x, float y, float width, float height,
+                          sf::Color color)
+{
+  rects.append(sf::Vertex({x, y}, color));
+  rects.append(sf::Vertex({x + width, y}, color));
+  rects.append(sf::Vertex({x, y + height}, color));
+  rects.append(sf::Vertex({x, y + height}, color));
+  rects.append(sf::Vertex({x + width, y}, color));
+  rects.append(sf::Vertex({x + width, y + height}, color));
+}
+
+void RenderBatch::addText(Item &item, const sf::Text &text, float x, float y,
+                          sf::Color color)
+{
+  item.layer = 0;
+  item.textFirst = item.textCount = 0;
+  const sf::Font *font = text.getFont();
+  if (!font)
+    return;
+
+  unsigned size = text.getCharacterSize();
+  size_t layer = 0;
+  while (layer < layers.size() &&
+         (layers[layer].font != font || layers[layer].characterSize != size))
+    ++layer;
+  if (layer == layers.size())
+  {
+    layers.emplace_back();
+    layers.back().font = font;
+    layers.back().characterSize = size;
+  }
+
+  TextLayer &target = layers[layer];
+  item.layer = layer;
+  item.textFirst = target.vertices.getVertexCount();
+  appendGlyphs(target.vertices, *font, size, text.getString(), x, y, color);
+  item.textCount = target.vertices.getVertexCount() - item.textFirst;
+  if (item.textCount > 0)
+    target.runs.push_back(items.size());
+}
+
+void RenderBatch::addDiv(Div &div, float x, float y, size_t parent,
+                         const sf::RenderWindow &window)
+{
+  // 元素上记录滚动后的位置，供 isHovered 与按钮的点击判断使用。
+  // 根 div 的位置是内容的原点，不随滚动改变
+  if (parent != NO_PARENT)
+  {
+    div.x = x;
+    div.y = y - placedScroll;
+  }
+  size_t index = divs.size();
+  DivItem item{&div, x, y, y + div.contentHeight, parent, div.isHovered(window)};
+  sf::Color background = div.getStyle(item.hovered).backgroundColor;
+  divRects.append(sf::Vertex({x, y}, background));
+  divRects.append(sf::Vertex({x + div.maxWidth, y}, background));
+  divRects.append(sf::Vertex({x, item.bottom}, background));
+  divRects.append(sf::Vertex({x, item.bottom}, background));
+  divRects.append(sf::Vertex({x + div.maxWidth, y}, background));
+  divRects.append(sf::Vertex({x + div.maxWidth, item.bottom}, background));
+  divs.push_back(item);
+
+  for (size_t i = 0; i < div.elements.size(); ++i)
+  {
+    Element &elem = div.elements[i];
+    float ey = y + div.elementOffsets[i];
+    Item it{Kind::Paragraph, nullptr, x, ey, ey, ey, false,
+            rects.getVertexCount(), 0, 0, 0, 0};
+    if (elem.type == ElementType::Paragraph)
+    {
+      Paragraph &p = *elem.paragraph;
+      p.setPosition(x, ey - placedScroll);
+      it.element = &p;
+      it.hovered = p.isHovered(window);
+      const Style &style = p.getStyle(it.hovered);
+
+      addRect(x, ey, p.width, p.height, style.backgroundColor);
+      addText(it, p.sfText, x, ey, style.textColor);
+    }
+    else if (elem.type == ElementType::Button)
+    {
+      Button &b = *elem.button;
+      b.setPosition(x, ey - placedScroll);
+      it.kind = Kind::Button;
+      it.element = &b;
+      it.hovered = b.isHovered(window);
+      const Style &style = b.getStyle(it.hovered);
+
+      // 与 sf::RectangleShape 相同：先填充，边框画在矩形外侧
+      addRect(x, ey, b.width, b.height, style.backgroundColor);
+      float t = style.borderThickness;
+      if (t > 0)
+      {
+        addRect(x - t, ey - t, b.width + t * 2, t, style.borderColor);
+        addRect(x - t, ey + b.height, b.width + t * 2, t, style.borderColor);
+        addRect(x - t, ey, t, b.height, style.borderColor);
+        addRect(x + b.width, ey, t, b.height, style.borderColor);
+      }
+
+      if (b.label.getCharacterSize() != style.fontSize)
+        b.label.setCharacterSize(style.fontSize);
+      sf::FloatRect textBounds = b.label.getLocalBounds();
+      float textX = x + (b.width - textBounds.width) / 2.f - textBounds.left;
+      float textY = ey + (b.height - textBounds.height) / 2.f - textBounds.top;
+      addText(it, b.label, textX, textY, style.textColor);
+    }
+    it.rectCount = rects.getVertexCount() - it.rectFirst;
+    extend(rects, it.rectFirst, it.rectCount, it.top, it.bottom);
+    if (it.textCount > 0)
+      extend(layers[it.layer].vertices, it.textFirst, it.textCount, it.top,
+             it.bottom);
+    items.push_back(it);
+  }
+
+  for (size_t i = 0; i < div.children.size(); ++i)
+    addDiv(div.children[i], x + 10, y + div.childOffsets[i], index, window);
+}
+
+void RenderBatch::rebuild(Div &root, const sf::RenderWindow &window)
+{
+  divRects.clear();
+  rects.clear();
+  for (TextLayer &layer : layers)
+  {
+    layer.vertices.clear();
+    layer.runs.clear();
+  }
+  items.clear();
+  divs.clear();
+
+  root.updateLayout();
+  placedScroll = scrollOffset;
+  mouse = sf::Mouse::getPosition(window);
+  addDiv(root, root.x, root.y, NO_PARENT, window);
+
+  size_t n = items.size();
+  maxBottom.resize(n);
+  minTop.resize(n);
+  for (size_t i = 0; i < n; ++i)
+    maxBottom[i] = i ? std::max(maxBottom[i - 1], items[i].bottom)
+                     : items[i].bottom;
+  for (size_t i = n; i-- > 0;)
+    minTop[i] = i + 1 < n ? std::min(minTop[i + 1], items[i].top)
+                          : items[i].top;
+
+  cull();
+  pressed = nullptr;
+  stamp = renderGeneration;
+}
+
+// 按 placedScroll 找出与窗口相交的元素与 div
+void RenderBatch::cull()
+{
+  float top = placedScroll;
+  float bottom = placedScroll + windowHeight;
+
+  visibleFirst = std::upper_bound(maxBottom.begin(), maxBottom.end(), top) -
+                 maxBottom.begin();
+  visibleLast = std::lower_bound(minTop.begin(), minTop.end(), bottom) -
+                minTop.begin();
+  visibleLast = std::max(visibleFirst, visibleLast);
+
+  for (TextLayer &layer : layers)
+  {
+    auto start = [&](size_t item)
+    {
+      auto it = std::lower_bound(layer.runs.begin(), layer.runs.end(), item);
+      return it == layer.runs.end() ? layer.vertices.getVertexCount()
+                                    : items[*it].textFirst;
+    };
+    layer.first = start(visibleFirst);
+    layer.count = start(visibleLast) - layer.first;
+  }
+
+  // 顶边在窗口上方的 div 中，只有最后一个及其祖先可能跨过窗口顶边
+  size_t d = std::upper_bound(divs.begin(), divs.end(), top,
+                              [](float y, const DivItem &item)
+                              { return y < item.y; }) -
+             divs.begin();
+  divChain.clear();
+  for (size_t p = d ? d - 1 : NO_PARENT; p != NO_PARENT; p = divs[p].parent)
+  {
+    if (divs[p].bottom > top)
+      divChain.push_back(p);
+  }
+  std::reverse(divChain.begin(), divChain.end());
+  divFirst = d;
+  divLast = std::lower_bound(divs.begin() + d, divs.end(), bottom,
+                             [](const DivItem &item, float y)
+                             { return item.y < y; }) -
+            divs.begin();
+}
+
+// 把 [visibleFirst, visibleLast) 中的元素按 placedScroll 的位置写回元素本身。
+// 滚动时在 cull() 前后各调用一次：离开窗口的元素被移到窗口外，不会停留在
+// 鼠标下面；从未进入窗口的元素保留 rebuild 时的位置，同样在窗口外
+void RenderBatch::moveVisible()
+{
+  for (size_t i = visibleFirst; i < visibleLast; ++i)
+  {
+    const Item &item = items[i];
+    if (item.kind == Kind::Paragraph)
+      static_cast<Paragraph *>(item.element)->setPosition(
+          item.x, item.y - placedScroll);
+    else
+      static_cast<Button *>(item.element)->setPosition(item.x,
+                                                       item.y - placedScroll);
+  }
+
+  auto move = [&](size_t d)
+  {
+    if (divs[d].parent == NO_PARENT)
+      return;
+    divs[d].div->x = divs[d].x;
+    divs[d].div->y = divs[d].y - placedScroll;
+  };
+  for (size_t d : divChain)
+    move(d);
+  for (size_t d = divFirst; d < divLast; ++d)
+    move(d);
+}
+
+void RenderBatch::recolorText(const Item &item, sf::Color color)
+{
+  if (item.textCount > 0)
+    recolor(layers[item.layer].vertices, item.textFirst, item.textCount, color);
+}
+
+// 悬停前后解析到样式表中的同一条样式（没有对应的 :hover 规则）时，
+// 顶点颜色不变。handle 必须已经由 getStyle 刷新
+static bool sameStyle(const StyleHandle &handle, bool a, bool b)
+{
+  return (a ? handle.ref.hover : handle.ref.normal) ==
+         (b ? handle.ref.hover : handle.ref.normal);
+}
+
+// 按新的悬停状态改写顶点颜色；样式改变了几何形状（按钮的字号或边框宽度）
+// 时返回 false，需要整体重建
+bool RenderBatch::paint(Item &item, bool hovered)
+{
+  if (item.kind == Kind::Paragraph)
+  {
+    const Paragraph &p = *static_cast<Paragraph *>(item.element);
+    const Style &style = p.getStyle(hovered);
+    if (!sameStyle(p.styleRef, item.hovered, hovered))
+    {
+      recolor(rects, item.rectFirst, item.rectCount, style.backgroundColor);
+      recolorText(item, style.textColor);
+    }
+  }
+  else
+  {
+    const Button &b = *static_cast<Button *>(item.element);
+    const Style &style = b.getStyle(hovered);
+    if (sameStyle(b.styleRef, item.hovered, hovered))
+    {
+      item.hovered = hovered;
+      return true;
+    }
+    const Style &old = b.getStyle(item.hovered);
+    if (style.fontSize != old.fontSize ||
+        style.borderThickness != old.borderThickness)
+      return false;
+    recolor(rects, item.rectFirst, 6, style.backgroundColor);
+    recolor(rects, item.rectFirst + 6, item.rectCount - 6, style.borderColor);
+    recolorText(item, style.textColor);
+  }
+  item.hovered = hovered;
+  return true;
+}
+
+void RenderBatch::paintDiv(DivItem &item, bool hovered)
+{
+  const Style &style = item.div->getStyle(hovered);
+  if (!sameStyle(item.div->styleRef, item.hovered, hovered))
+  {
+    size_t index = &item - divs.data();
+    recolor(divRects, index * 6, 6, style.backgroundColor);
+  }
+  item.hovered = hovered;
+}
+
+// 只检查可见的元素；其余元素重新进入窗口时（滚动同样会触发这里）再检查
+bool RenderBatch::updateHover(const sf::RenderWindow &window)
+{
+  for (size_t i = visibleFirst; i < visibleLast; ++i)
+  {
+    Item &item = items[i];
+    bool hovered =
+        item.kind == Kind::Paragraph
+            ? static_cast<Paragraph *>(item.element)->isHovered(window)
+            : static_cast<Button *>(item.element)->isHovered(window);
+    if (hovered != item.hovered && !paint(item, hovered))
+      return false;
+  }
+
+  auto check = [&](size_t d)
+  {
+    bool hovered = divs[d].div->isHovered(window);
+    if (hovered != divs[d].hovered)
+      paintDiv(divs[d], hovered);
+  };
+  for (size_t d : divChain)
+    check(d);
+  for (size_t d = divFirst; d < divLast; ++d)
+    check(d);
+  return true;
+}
+
+// 只把事件交给窗口内的按钮；窗口外的按钮不在鼠标下面，不会被点中。
+// 按下后滚出窗口的按钮不会收到松开事件，在这里复位
+bool RenderBatch::handleEvent(const sf::Event &event,
+                              const sf::RenderWindow &window)
+{
+  if (stamp != renderGeneration)
+    return false;
+  for (size_t i = visibleFirst; i < visibleLast; ++i)
+  {
+    if (items[i].kind != Kind::Button)
+      continue;
+    Button &b = *static_cast<Button *>(items[i].element);
+    b.handleEvent(event, window);
+    if (b.pressed)
+      pressed = &b;
+    // onClick 改变了页面，items 与 pressed 可能已经失效
+    if (stamp != renderGeneration)
+    {
+      pressed = nullptr;
+      return true;
+    }
+  }
+  if (event.type == sf::Event::MouseButtonReleased && pressed)
+  {
+    pressed->pressed = false;
+    pressed = nullptr;
+  }
+  return true;
+}
+
+void RenderBatch::draw(Div &root, sf::RenderWindow &window)
+{
+  if (stamp != renderGeneration)
+  {
+    rebuild(root, window);
+  }
+  else
+  {
+    // 页面、滚动量与鼠标位置都没变时什么也不用做
+    bool scrolled = scrollOffset != placedScroll;
+    if (scrolled)
+    {
+      // 先按新的滚动量移动原来可见的元素，离开窗口的元素随之移出窗口，
+      // 再移动新进入窗口的元素
+      placedScroll = scrollOffset;
+      moveVisible();
+      cull();
+      moveVisible();
+    }
+    sf::Vector2i now = sf::Mouse::getPosition(window);
+    if (scrolled || now != mouse)
+    {
+      mouse = now;
+      if (!updateHover(window))
+        rebuild(root, window);
+    }
+  }
+
+  // 创建视图(viewport)来实现滚动效果
+  sf::View view = window.getDefaultView();
+  view.setViewport(sf::FloatRect(0, 0, 1, 1));
+  view.reset(sf::FloatRect(root.x, root.y, root.maxWidth, windowHeight - root.y));
+  window.setView(view);
+
+  sf::RenderStates states;
+  states.transform.translate(0.f, -placedScroll);
+  for (size_t d : divChain)
+    window.draw(&divRects[d * 6], 6, sf::Triangles, states);
+  if (divLast > divFirst)
+    window.draw(&divRects[divFirst * 6], (divLast - divFirst) * 6,
+                sf::Triangles, states);
+
+  if (visibleLast > visibleFirst)
+  {
+    size_t first = items[visibleFirst].rectFirst;
+    size_t last = visibleLast < items.size() ? items[visibleLast].rectFirst
+                                             : rects.getVertexCount();
+    window.draw(&rects[first], last - first, sf::Triangles, states);
+  }
+  for (TextLayer &layer : layers)
+  {
+    if (layer.count == 0)
+      continue;
+    states.texture = &layer.font->getTexture(layer.characterSize);
+    window.draw(&layer.vertices[layer.first], layer.count, sf::Triangles,
+                states);
+  }
+
+  // 恢复默认视图
+  window.setView(window.getDefaultView());
+}
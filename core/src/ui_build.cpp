@@ -0,0 +1,50 @@
+#include "ui_build.h"
+
+void build_ui_table(Div &root, const ui_element *elements, ui_range range,
+                    const char *strings, const ui_range *components,
+                    const sf::Font &font, unsigned generation)
+{
+  auto str = [strings](ui_str s) { return std::string(strings + s.offset, s.length); };
+
+  // divs[i] 指向第 i 个元素创建的 div。父节点总在子节点之前，且一个 div 的
+  // 子树处理完之前它的父节点不会再添加子 div，因此这些指针在使用时都有效
+  std::vector<Div *> divs(range.count, nullptr);
+  for (uint32_t i = 0; i < range.count; ++i)
+  {
+    const ui_element &e = elements[range.first + i];
+    Div &target = e.parent < 0 ? root : *divs[e.parent];
+    StyleHandle style(StyleRef{e.style, e.hover_style}, generation);
+
+    switch (e.type)
+    {
+    case UI_PARAGRAPH:
+      target.addParagraph(str(e.text), font, e.font_size, str(e.id),
+                          str(e.class_name), style);
+      break;
+    case UI_BUTTON:
+      target.addButton(str(e.text), font, str(e.id), str(e.class_name), style);
+      break;
+    case UI_DIV:
+      target.children.emplace_back(10, 0, str(e.id), str(e.class_name), style);
+      divs[i] = &target.children.back();
+      break;
+    case UI_COMPONENT:
+      if (components)
+      {
+        build_ui_table(target, elements, components[e.component], strings,
+                       components, font, generation);
+      }
+      break;
+    }
+  }
+  invalidateLayout(); // 上面直接向 children 添加 div
+}
+
+void build_ui(Div &root, const ui_document &doc, const sf::Font &font)
+{
+  // 元素的样式下标由 mkcc 按这份样式表算出，必须从空表开始解析
+  reset_styles();
+  parse_css_style(std::string(doc.str(doc.css)));
+  build_ui_table(root, doc.elements.data(), doc.body, doc.strings.data(),
+                 doc.components.data(), font, styleGeneration);
+}
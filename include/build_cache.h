@@ -0,0 +1,174 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+
+// 构建缓存：记录每个输入的内容哈希，输入全部未变时跳过代码生成与编译
+
+// FNV-1a 64 位哈希，足够用于变更检测
+inline uint64_t hash_bytes(const char* data, size_t size,
+                           uint64_t seed = 14695981039346656037ull)
+{
+  uint64_t h = seed;
+  for (size_t i = 0; i < size; ++i)
+  {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+inline std::string hash_hex(uint64_t h)
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string out(16, '0');
+  for (int i = 15; i >= 0; --i)
+  {
+    out[i] = digits[h & 0xf];
+    h >>= 4;
+  }
+  return out;
+}
+
+inline std::string hash_string(const std::string& s)
+{
+  return hash_hex(hash_bytes(s.data(), s.size()));
+}
+
+// 文件不存在时返回空串，与任何记录的哈希都不相等
+inline std::string hash_file(const std::string& path)
+{
+  // 常驻进程中，修改时间与大小都未变的文件不再重新读取
+  struct cached_hash
+  {
+    file_stamp stamp;
+    std::string hash;
+  };
+  static file_cache<cached_hash> cache;
+  file_stamp stamp;
+  std::string key;  // 请求之间工作目录会变，按绝对路径缓存
+  if (file_caches_enabled)
+  {
+    std::error_code ec;
+    key = std::filesystem::absolute(path, ec).string();
+    stamp = stat_file(path);
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.entries.find(key);
+    if (it != cache.entries.end() && it->second.stamp == stamp)
+      return it->second.hash;
+  }
+
+  mapped_file file(path);
+  std::string hash;
+  if (file)
+  {
+    std::string_view data = file.view();
+    hash = hash_hex(hash_bytes(data.data(), data.size()));
+  }
+  if (file_caches_enabled)
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.entries[key] = {stamp, hash};
+  }
+  return hash;
+}
+
+// 按相对路径排序后哈希整个目录，保证结果与遍历顺序无关
+inline std::string hash_directory(const std::filesystem::path& dir)
+{
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  if (!fs::is_directory(dir, ec)) return "";
+
+  std::map<std::string, std::string> files;
+  for (const auto& entry : fs::recursive_directory_iterator(dir, ec))
+  {
+    if (!entry.is_regular_file()) continue;
+    files[fs::relative(entry.path(), dir).generic_string()] =
+        hash_file(entry.path().string());
+  }
+
+  std::string combined;
+  for (const auto& [name, h] : files)
+  {
+    combined += name + '\0' + h + '\n';
+  }
+  return hash_string(combined);
+}
+
+struct build_cache
+{
+  std::string config;                         // mkccmake.json 字段
+  std::string runtime;                        // main.cpp 模板与运行时
+  std::string flags;                          // 编译器与编译参数
+  std::map<std::string, std::string> inputs;  // 入口文件及 <style>/<script> src
+
+  // 所有记录的输入仍然与磁盘一致
+  bool inputs_unchanged() const
+  {
+    if (inputs.empty()) return false;
+    for (const auto& [path, h] : inputs)
+    {
+      if (hash_file(path) != h) return false;
+    }
+    return true;
+  }
+};
+
+inline build_cache load_build_cache(const std::string& path)
+{
+  build_cache cache;
+  std::ifstream file(path);
+  if (!file) return cache;
+
+  try
+  {
+    nlohmann::json j;
+    file >> j;
+    cache.config = j.value("config", "");
+    cache.runtime = j.value("runtime", "");
+    cache.flags = j.value("flags", "");
+    cache.inputs =
+        j.value("inputs", std::map<std::string, std::string>{});
+  }
+  catch (const std::exception&)
+  {
+    // 缓存损坏时视为无缓存，下次构建会重新生成
+    return build_cache{};
+  }
+  return cache;
+}
+
+inline void save_build_cache(const std::string& path, const build_cache& cache)
+{
+  nlohmann::json j;
+  j["config"] = cache.config;
+  j["runtime"] = cache.runtime;
+  j["flags"] = cache.flags;
+  j["inputs"] = cache.inputs;
+
+  std::ofstream file(path);
+  if (file) file << j.dump(2) << "\n";
+}
+
+// 内容相同时不写文件，保留 mtime；返回是否发生了写入
+inline bool write_file_if_changed(const std::string& path,
+                                  std::string_view content)
+{
+  {
+    mapped_file existing(path);
+    if (existing && existing.view() == content) return false;
+  }
+
+  write_whole_file(path, content);
+  return true;
+}
@@ -0,0 +1,420 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "compiler.h"
+
+// mkcc check：解析 MKML 并按 compile() 支持的标签与属性校验，
+// 不写任何文件，也不调用编译器
+
+enum class diagnostic_level
+{
+  warning,
+  error
+};
+
+struct diagnostic
+{
+  std::string file;
+  int line = 0;
+  int column = 0;  // 0 表示未知
+  diagnostic_level level = diagnostic_level::error;
+  std::string message;
+};
+
+// 与 gcc 相同的 file:line:col: error: message 格式，编辑器可以直接跳转
+inline std::string format_diagnostic(const diagnostic& d)
+{
+  std::string out = d.file + ":" + std::to_string(d.line);
+  if (d.column > 0) out += ":" + std::to_string(d.column);
+  out += d.level == diagnostic_level::error ? ": error: " : ": warning: ";
+  return out + d.message;
+}
+
+class mkml_checker
+{
+public:
+  mkml_checker(const std::string& file, std::string_view source)
+      : file(file), source(source)
+  {
+    line_starts.push_back(0);
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+      if (source[i] == '\n') line_starts.push_back(i + 1);
+    }
+  }
+
+  // run() 之后有效：页面引用的样式、脚本与被包含的文件，只在
+  // file_caches_enabled 时收集，用于判断缓存的诊断是否过期
+  std::vector<std::string> sources;
+
+  std::vector<diagnostic> run()
+  {
+    std::vector<mkml_parse_error> errors;
+    mkml_document doc = parse_html_to_mkml(source, &errors);
+    const mkml_node& root = *doc.root;
+    for (const auto& e : errors)
+    {
+      report(e.line, e.column, diagnostic_level::error, e.message);
+    }
+    if (root.name.empty()) return std::move(diagnostics);
+    components = std::make_unique<component_table>(root);
+    if (file_caches_enabled) sources = collect_sources(root);
+
+    bool has_body = false;
+    for (const auto& node : root.children())
+    {
+      int column = locate(node);
+      if (node.tag == ATOM_HEAD)
+      {
+        check_head(node);
+      }
+      else if (node.tag == ATOM_BODY)
+      {
+        has_body = true;
+        check_body(node);
+      }
+      else
+      {
+        report(node.line, column, diagnostic_level::warning,
+               tag(node) + " outside <head>/<body> is ignored");
+      }
+    }
+    if (!has_body)
+    {
+      report(1, 0, diagnostic_level::warning, "document has no <body>");
+    }
+    return std::move(diagnostics);
+  }
+
+private:
+  static std::string tag(const mkml_node& node)
+  {
+    return "<" + std::string(node.name) + ">";
+  }
+
+  void report(int line, int column, diagnostic_level level,
+              const std::string& message)
+  {
+    diagnostics.push_back({file, line, column, level, message});
+  }
+
+  // libxml2 只记录行号：在该行按文档顺序查找起始标签得到列号。
+  // 解析器补出的隐式元素（如省略的 <body>）在源码中找不到，返回 0
+  int locate(const mkml_node& node)
+  {
+    if (node.line <= 0 || node.line > static_cast<int>(line_starts.size()))
+      return 0;
+    size_t line_start = line_starts[node.line - 1];
+    size_t line_end = node.line < static_cast<int>(line_starts.size())
+                          ? line_starts[node.line]
+                          : source.size();
+    size_t& cursor = cursors[node.line];
+    std::string open = "<" + std::string(node.name);
+    for (size_t i = std::max(line_start, cursor); i + open.size() <= line_end;
+         ++i)
+    {
+      bool match = true;
+      for (size_t k = 0; k < open.size() && match; ++k)
+      {
+        match = std::tolower(static_cast<unsigned char>(source[i + k])) ==
+                open[k];
+      }
+      size_t after = i + open.size();
+      if (match && (after >= source.size() ||
+                    !std::isalnum(static_cast<unsigned char>(source[after]))))
+      {
+        cursor = after;
+        return static_cast<int>(i - line_start) + 1;
+      }
+    }
+    return 0;
+  }
+
+  void check_attributes(const mkml_node& node, int column,
+                        std::initializer_list<mkml_atom> allowed)
+  {
+    for (const auto& attr : node.attributes())
+    {
+      if (std::find(allowed.begin(), allowed.end(), attr.key) != allowed.end())
+        continue;
+      report(node.line, column, diagnostic_level::warning,
+             "attribute '" + std::string(attr.name) + "' on " + tag(node) +
+                 " is ignored");
+    }
+  }
+
+  void check_source_file(const mkml_node& node, int column)
+  {
+    if (!node.has_attr(ATOM_SRC)) return;
+    std::string src(node.attr(ATOM_SRC));
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(src, ec))
+    {
+      report(node.line, column, diagnostic_level::error,
+             "cannot open <" + std::string(node.name) + " src=\"" + src +
+                 "\">");
+    }
+    else if (node.content.find_first_not_of(" \n\t\r") !=
+             std::string_view::npos)
+    {
+      report(node.line, column, diagnostic_level::warning,
+             "inline content of " + tag(node) +
+                 " is ignored because src is set");
+    }
+  }
+
+  // <head> 中除 style/script 外的元素都会生成 #define MKML<标签>[_<属性>] "值"
+  void check_head(const mkml_node& head)
+  {
+    for (const auto& child : head.children())
+    {
+      int column = locate(child);
+      if (child.tag == ATOM_STYLE || child.tag == ATOM_SCRIPT)
+      {
+        check_attributes(child, column, {ATOM_SRC});
+        check_source_file(child, column);
+        continue;
+      }
+      if (child.tag == ATOM_TEMPLATE || child.tag == ATOM_USE ||
+          child.tag == ATOM_INCLUDE)
+      {
+        report(child.line, column, diagnostic_level::warning,
+               tag(child) + " is only supported in <body>");
+        continue;
+      }
+
+      std::string name(child.name);
+      check_macro_name(child, column, name);
+      for (const auto& attr : child.attributes())
+      {
+        check_macro_name(child, column, name + "_" + std::string(attr.name));
+      }
+      for (const auto& nested : child.children())
+      {
+        report(nested.line, locate(nested), diagnostic_level::warning,
+               tag(nested) + " inside " + tag(child) + " is ignored");
+      }
+    }
+  }
+
+  // 值由生成器转义后写入字符串字面量，只有宏名需要检查
+  void check_macro_name(const mkml_node& node, int column,
+                        const std::string& key)
+  {
+    for (char c : sanitize_key(key))
+    {
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_')
+      {
+        report(node.line, column, diagnostic_level::error,
+               "'" + key + "' is not a valid macro name");
+        return;
+      }
+    }
+  }
+
+  // <use>/<include> 必须能找到组件，且组件不能直接或间接引用自己
+  void check_reference(const mkml_node& node, int column)
+  {
+    mkml_atom key = node.tag == ATOM_USE ? ATOM_NAME : ATOM_SRC;
+    mkml_component* component = components->find(node);
+    if (node.attr(key).empty())
+    {
+      report(node.line, column, diagnostic_level::error,
+             tag(node) + " requires " +
+                 (key == ATOM_NAME ? "a name" : "a src"));
+    }
+    else if (!component)
+    {
+      if (node.tag == ATOM_USE)
+      {
+        report(node.line, column, diagnostic_level::error,
+               "unknown component '" + std::string(node.attr(ATOM_NAME)) +
+                   "'");
+      }
+      else
+      {
+        report(node.line, column, diagnostic_level::error,
+               "cannot open <include src=\"" +
+                   std::string(node.attr(ATOM_SRC)) + "\">");
+      }
+    }
+    else if (has_cycle(*component))
+    {
+      report(node.line, column, diagnostic_level::error,
+             "component '" + component->label + "' uses itself");
+    }
+    for (const auto& nested : node.children())
+    {
+      report(nested.line, locate(nested), diagnostic_level::warning,
+             tag(nested) + " inside " + tag(node) + " is ignored");
+    }
+  }
+
+  // 沿组件内容中的 <use>/<include> 深度优先查找回到自身的路径。
+  // 没有循环的组件标记为 done，之后不再展开
+  bool has_cycle(mkml_component& component)
+  {
+    if (component.expanding) return true;
+    if (component.done) return false;
+    component.expanding = true;
+    bool cycle = references_cycle(*component.node);
+    component.expanding = false;
+    component.done = !cycle;
+    return cycle;
+  }
+
+  bool references_cycle(const mkml_node& node)
+  {
+    for (const auto& child : node.children())
+    {
+      if (child.tag == ATOM_TEMPLATE) continue;  // 定义本身不展开
+      if (child.tag == ATOM_USE || child.tag == ATOM_INCLUDE)
+      {
+        mkml_component* component = components->find(child);
+        if (component && has_cycle(*component)) return true;
+      }
+      else if (references_cycle(child))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // 与 ui_table_builder::add_children 支持的元素保持一致
+  void check_body(const mkml_node& node)
+  {
+    for (const auto& child : node.children())
+    {
+      int column = locate(child);
+      switch (child.tag)
+      {
+      case ATOM_DIV:
+        check_attributes(child, column, {ATOM_ID, ATOM_CLASS});
+        check_body(child);
+        break;
+      case ATOM_P:
+      case ATOM_H1:
+      case ATOM_H2:
+      case ATOM_H3:
+      case ATOM_H4:
+      case ATOM_H5:
+      case ATOM_H6:
+      case ATOM_BUTTON:
+        check_attributes(child, column, {ATOM_ID, ATOM_CLASS});
+        for (const auto& nested : child.children())
+        {
+          report(nested.line, locate(nested), diagnostic_level::warning,
+                 tag(nested) + " inside " + tag(child) +
+                     " is ignored, only its text is used");
+        }
+        break;
+      case ATOM_TEMPLATE:
+      {
+        check_attributes(child, column, {ATOM_NAME});
+        std::string name(child.attr(ATOM_NAME));
+        if (name.empty())
+        {
+          report(child.line, column, diagnostic_level::error,
+                 "<template> requires a name");
+        }
+        else if (!template_lines.emplace(name, child.line).second)
+        {
+          report(child.line, column, diagnostic_level::error,
+                 "component '" + name + "' is already defined at line " +
+                     std::to_string(template_lines[name]));
+        }
+        check_body(child);
+        break;
+      }
+      case ATOM_USE:
+        check_attributes(child, column, {ATOM_NAME});
+        check_reference(child, column);
+        break;
+      case ATOM_INCLUDE:
+        check_attributes(child, column, {ATOM_SRC});
+        check_reference(child, column);
+        break;
+      case ATOM_SCRIPT:
+      case ATOM_STYLE:
+        report(child.line, column, diagnostic_level::warning,
+               tag(child) + " is only supported in <head>");
+        break;
+      default:
+        report(child.line, column, diagnostic_level::warning,
+               "unsupported tag " + tag(child) + " is ignored");
+        break;
+      }
+    }
+  }
+
+  std::string file;
+  std::string_view source;
+  std::vector<size_t> line_starts;
+  std::unordered_map<int, size_t> cursors;  // 每行已匹配到的位置
+  std::vector<diagnostic> diagnostics;
+  std::unique_ptr<component_table> components;  // 解析成功后创建
+  std::unordered_map<std::string, int> template_lines;  // 模板名 → 定义所在行
+};
+
+inline std::vector<diagnostic> check_mkml_file(const std::string& path)
+{
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(path, ec))
+  {
+    return {{path, 0, 0, diagnostic_level::error, "cannot open file"}};
+  }
+  // mkcc serve 中文件本身与它引用的文件都未变时，直接返回上次的诊断
+  struct cached_check
+  {
+    std::vector<std::pair<std::string, file_stamp>> inputs;
+    std::vector<diagnostic> diagnostics;
+  };
+  static file_cache<cached_check> cache;
+  std::string absolute, key;
+  file_stamp stamp;  // 读取之前取得，文件在检查期间变化时下次会重新检查
+  if (file_caches_enabled)
+  {
+    // 诊断中使用调用方给出的路径，因此它也是键的一部分
+    absolute = std::filesystem::absolute(path, ec).string();
+    key = absolute + '\0' + path;
+    stamp = stat_file(path);
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.entries.find(key);
+    if (it != cache.entries.end() &&
+        std::all_of(it->second.inputs.begin(), it->second.inputs.end(),
+                    [](const auto& input)
+                    { return stat_file(input.first) == input.second; }))
+      return it->second.diagnostics;
+  }
+
+  mapped_file source(path);
+  mkml_checker checker(path, source.view());
+  std::vector<diagnostic> diagnostics = checker.run();
+  std::stable_sort(diagnostics.begin(), diagnostics.end(),
+                   [](const diagnostic& a, const diagnostic& b)
+                   {
+                     return std::tie(a.line, a.column) <
+                            std::tie(b.line, b.column);
+                   });
+  if (file_caches_enabled)
+  {
+    cached_check entry{{{absolute, stamp}}, diagnostics};
+    for (const auto& src : checker.sources)
+    {
+      std::string input = std::filesystem::absolute(src, ec).string();
+      entry.inputs.emplace_back(input, stat_file(input));
+    }
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.entries[key] = std::move(entry);
+  }
+  return diagnostics;
+}
@@ -1,366 +1,860 @@
 #pragma once
 #include <libxml/HTMLparser.h>
 #include <libxml/parser.h>
+#include <libxml/SAX2.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <unordered_map>
-#include <random>
 
-enum body_type {
-    Paragraph,
-    Button
-};
-struct body_code {
-    std::string parent_var;
-    std::unordered_map<std::string, std::string> *parent_attrs;
-    int body_type;
-    std::string text;
-    int font_size;
-    std::unordered_map<std::string, std::string> attrs;
-};
-struct div_body {
-    std::string var;
-    std::unordered_map<std::string, std::string> *parent_attrs;
-};
-void write_file(const std::string& path, const std::string& content)
+#include "../core/include/css.h"
+#include "../core/include/ui_desc.h"
+#include "mapped_file.h"
+#include "mkml_tree.h"
+#include "trace.h"
+
+inline void write_file(const std::string& path, std::string_view content)
 {
-  std::ofstream file(path);
-  if (file) file << content;
+  write_whole_file(path, content);
 }
 
-std::string read_file(const std::string& path) {
-    std::ifstream file(path);
-    if (!file) return "";
-
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    return ss.str();
+// 需要持有副本时使用；只读一次的输入直接用 mapped_file 的视图
+inline std::string read_file(const std::string& path) {
+    mapped_file file(path);
+    return std::string(file.view());
 }
 
-class mkml_node {
-public:
-    std::string name;                    // 节点名，例如 head、title、body
-    std::string content;                 // 文本内容
-    std::vector<mkml_node> children;     // 子节点
-    std::unordered_map<std::string, std::string> attrs; // 属性键值对
-    std::string note;
-    mkml_node* parent=nullptr;
-    mkml_node() = default;
-    mkml_node(const std::string& n) : name(n) {}
-
+// libxml2 报告的解析错误，column 为 0 表示未知
+struct mkml_parse_error {
+    int line;
+    int column;
+    std::string message;
 };
 
-// 解析 HTML 节点并构建 mkml_node 树
-inline mkml_node build_mkml_tree(xmlNode* xml_node) {
-    mkml_node node;
+#if LIBXML_VERSION >= 21200
+inline void collect_parse_error(void* data, const xmlError* error) {
+#else
+inline void collect_parse_error(void* data, xmlErrorPtr error) {
+#endif
+    // MKML 的 <size> 等标签不是 HTML 标签，未知标签由 mkcc check 按 MKML 规则检查
+    if (error->code == XML_HTML_UNKNOWN_TAG) return;
+    std::string message = error->message ? error->message : "parse error";
+    while (!message.empty() && (message.back() == '\n' || message.back() == ' '))
+        message.pop_back();
+    static_cast<std::vector<mkml_parse_error>*>(data)->push_back(
+        {error->line, error->int2, message});
+}
 
-    if (xml_node->type == XML_ELEMENT_NODE) {
-        node.name = (const char*)xml_node->name;
+// 由 libxml2 的 SAX 回调直接构建 mkml_node 树，不经过 DOM。
+// 节点、属性与文本分配在文档的 arena 中，子节点按链表挂到父节点上，整棵树没有拷贝。
+// 文本由 libxml2 解码实体后交给回调，因此复制进 arena 而不是指向源码
+struct mkml_sax_builder {
+    struct open_element {
+        mkml_node* node;         // 被忽略的元素为空
+        mkml_node* last_child;
+        std::string content;     // 已归属的文本，元素结束时一次复制进 arena
+    };
+
+    htmlParserCtxtPtr ctxt = nullptr;
+    mkml_document doc;
+    bool has_root = false;
+    std::vector<open_element> open; // 当前打开的元素
+    std::string pending;            // 尚未归属的文本，元素边界处统一处理
+    bool raw = false;               // 位于 style/script 内，文本原样保留
+
+    // 与原先的 DOM 版本一致：只含空白的文本节点忽略，其余追加到所属元素。
+    // 被子元素或注释隔开的多段文本先在 open_element::content 中拼接，
+    // 结束标签处才复制进 arena，分成很多段的文本也只复制一次
+    void flush_text() {
+        if (!pending.empty() && !open.empty() && open.back().node &&
+            pending.find_first_not_of(" \n\t\r") != std::string::npos) {
+            open.back().content += pending;
+        }
+        pending.clear();
+    }
 
-        // 提取属性
-        for (xmlAttr* attr = xml_node->properties; attr; attr = attr->next) {
-            std::string key = (const char*)attr->name;
-            std::string val = (const char*)xmlNodeGetContent(attr->children);
-            node.attrs[key] = val;
+    static void start_element(void* data, const xmlChar* name, const xmlChar** atts) {
+        auto* b = static_cast<mkml_sax_builder*>(data);
+        b->flush_text();
+        // style/script 只收集文本，其中的元素（以及根节点之外的元素）忽略
+        if (b->raw || (b->open.empty() ? b->has_root : !b->open.back().node)) {
+            b->open.push_back({nullptr, nullptr, {}});
+            return;
         }
 
-        // 对于 style，script，直接收集文本内容
-        if (node.name == "style" || node.name == "script") {
-            xmlChar* raw_content = xmlNodeGetContent(xml_node);
-            if (raw_content) {
-                node.content = (const char*)raw_content;
-                xmlFree(raw_content);
+        mkml_node* node = b->doc.root;
+        if (b->open.empty()) {
+            b->has_root = true;
+        } else {
+            node = b->doc.arena.create<mkml_node>();
+            open_element& parent = b->open.back();
+            node->parent = parent.node;
+            (parent.last_child ? parent.last_child->next_sibling : parent.node->first_child) = node;
+            parent.last_child = node;
+        }
+        node->tag = b->doc.intern(reinterpret_cast<const char*>(name), node->name);
+        node->line = xmlSAX2GetLineNumber(b->ctxt);
+
+        uint32_t count = 0;
+        for (const xmlChar** a = atts; a && a[0]; a += 2) ++count;
+        if (count > 0) {
+            auto* attrs = static_cast<mkml_attr*>(
+                b->doc.arena.allocate(count * sizeof(mkml_attr), alignof(mkml_attr)));
+            for (uint32_t i = 0; i < count; ++i) {
+                const xmlChar* key = atts[i * 2];
+                const xmlChar* value = atts[i * 2 + 1];
+                mkml_attr* attr = new (&attrs[i]) mkml_attr{};
+                attr->key = b->doc.intern(reinterpret_cast<const char*>(key), attr->name);
+                // 没有值的属性（如 <input disabled>）与 DOM 一样取属性名为值
+                attr->value = b->doc.arena.copy(reinterpret_cast<const char*>(value ? value : key));
             }
-            return node;
+            node->attrs = attrs;
+            node->attr_count = count;
+        }
+        b->raw = node->tag == ATOM_STYLE || node->tag == ATOM_SCRIPT;
+        b->open.push_back({node, nullptr, {}});
+    }
+
+    static void end_element(void* data, const xmlChar*) {
+        auto* b = static_cast<mkml_sax_builder*>(data);
+        if (b->open.empty()) return;
+        open_element& element = b->open.back();
+        if (element.node && b->raw) {
+            element.content += b->pending;
+            b->pending.clear();
+            b->raw = false;
         }
+        b->flush_text();
+        if (element.node && !element.content.empty())
+            element.node->content = b->doc.arena.copy(element.content);
+        b->open.pop_back();
+    }
+
+    static void characters(void* data, const xmlChar* text, int len) {
+        auto* b = static_cast<mkml_sax_builder*>(data);
+        b->pending.append(reinterpret_cast<const char*>(text), len);
+    }
 
+    // 注释把两侧的文本分成两个文本节点，分别判断是否只含空白
+    static void comment(void* data, const xmlChar*) {
+        auto* b = static_cast<mkml_sax_builder*>(data);
+        if (!b->raw) b->flush_text();
+    }
+};
 
+// 顶层函数，传入 HTML 文本返回 mkml 文档。errors 非空时收集解析错误
+inline mkml_document parse_html_to_mkml(std::string_view html,
+                                        std::vector<mkml_parse_error>* errors = nullptr) {
+    htmlSAXHandler sax;
+    std::memset(&sax, 0, sizeof(sax));
+    sax.startElement = mkml_sax_builder::start_element;
+    sax.endElement = mkml_sax_builder::end_element;
+    sax.characters = mkml_sax_builder::characters;
+    sax.cdataBlock = mkml_sax_builder::characters;  // style/script 的内容
+    sax.comment = mkml_sax_builder::comment;
+
+    mkml_sax_builder builder;
+    htmlParserCtxtPtr ctxt = htmlCreateMemoryParserCtxt(html.data(), static_cast<int>(html.size()));
+    if (!ctxt) {
+        if (errors) errors->push_back({1, 0, "Failed to parse MKML"});
+        else std::cerr << "Failed to parse MKML.\n";
+        return std::move(builder.doc);
+    }
+    builder.ctxt = ctxt;
+    std::memcpy(ctxt->sax, &sax, sizeof(sax));
+    ctxt->userData = &builder;
+    htmlCtxtUseOptions(ctxt, errors ? 0 : HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING);
+
+    // 结构化错误回调保存在 libxml2 的线程局部状态中，各线程互不影响
+    if (errors) xmlSetStructuredErrorFunc(errors, collect_parse_error);
+    htmlParseDocument(ctxt);
+    if (errors) xmlSetStructuredErrorFunc(nullptr, nullptr);
+    // libxml2 在文档结束时会关闭所有元素，这里只是保证 style/script 的文本不丢失
+    while (!builder.open.empty()) mkml_sax_builder::end_element(&builder, nullptr);
+
+    // 不调用 xmlCleanupParser()：它会释放全局状态，之后无法在其他线程或
+    // 同一进程中再次解析。libxml2 由 main() 中的 xmlInitParser() 初始化一次
+    htmlFreeParserCtxt(ctxt);
+    return std::move(builder.doc);
+}
 
-    } else if (xml_node->type == XML_TEXT_NODE) {
-        std::string text = (const char*)xml_node->content;
-        if (text.find_first_not_of(" \n\t\r") == std::string::npos)
-            return {}; // 空白节点忽略
-        node.name = "#text";
-        node.content = text;
-        return node;
+// 解析 MKML 文件，文件无法打开或为空时返回空。开启 file_caches_enabled 时
+// （mkcc serve），修改时间与大小都未变的文件直接返回上次的解析结果
+inline std::shared_ptr<const mkml_document> load_mkml_file(const std::string& path) {
+    static file_cache<std::pair<file_stamp, std::shared_ptr<const mkml_document>>> cache;
+    file_stamp stamp;
+    std::string key;
+    if (file_caches_enabled) {
+        std::error_code ec;
+        key = std::filesystem::absolute(path, ec).string();
+        stamp = stat_file(path);
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        auto it = cache.entries.find(key);
+        if (it != cache.entries.end() && it->second.first == stamp) return it->second.second;
     }
 
-    // 递归处理子节点（非 style）
-    for (xmlNode* child = xml_node->children; child; child = child->next) {
-        mkml_node child_node = build_mkml_tree(child);
-        if (!child_node.name.empty()) {
-            if (child_node.name == "#text") {
-                node.content += child_node.content;
-            } else {
-                node.children.push_back(child_node);
-            }
+    mapped_file file(path);
+    if (file.view().empty()) return nullptr;
+    auto doc = std::make_shared<const mkml_document>(parse_html_to_mkml(file.view()));
+    if (file_caches_enabled) {
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        cache.entries[key] = {stamp, doc};
+    }
+    return doc;
+}
+// 以 C++ 字符串字面量（含两侧引号）追加文本，一次扫描完成转义：
+// 不需要转义的连续片段整段复制，换行替换为空格
+inline void append_literal(std::string& out, std::string_view text) {
+    out += '"';
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char* escaped;
+        switch (text[i]) {
+        case '"': escaped = "\\\""; break;
+        case '\\': escaped = "\\\\"; break;
+        case '\n':
+        case '\r': escaped = " "; break;
+        default: continue;
         }
+        out.append(text.data() + run, i - run);
+        out += escaped;
+        run = i + 1;
     }
+    out.append(text.data() + run, text.size() - run);
+    out += '"';
+}
+inline void append_int(std::string& out, int value) {
+    char buffer[16];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+// 以 float 字面量追加，例如 5.f、1.5f
+inline void append_float(std::string& out, float value) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    out.append(buffer, length);
+    if (std::string_view(buffer, length).find_first_of(".e") == std::string_view::npos) out += '.';
+    out += 'f';
+}
+inline void append_style_ref(std::string& out, const css_style_ref& ref) {
+    out += '{';
+    append_int(out, static_cast<int>(ref.normal));
+    out += ", ";
+    append_int(out, static_cast<int>(ref.hover));
+    out += '}';
+}
 
-    return node;
+// p 与 h1-h6 的默认字号
+inline int element_font_size(mkml_atom tag) {
+    switch (tag) {
+    case ATOM_H1: return 32;
+    case ATOM_H2: return 24;
+    case ATOM_H3: return 19;
+    case ATOM_H5: return 13;
+    case ATOM_H6: return 11;
+    default: return 16; // p、h4
+    }
 }
+inline std::string sanitize_key(std::string_view key) {
+    std::string result(key);
+    for (char& c : result) {
+        if (c == '-') c = '_';
+    }
+    return result;
+}
+// <template name> 或 <include src> 定义的组件，node 的子节点即组件内容
+struct mkml_component {
+    std::string label;       // 模板名或文件路径，用于错误信息
+    const mkml_node* node = nullptr;
+    bool expanding = false;  // 正在展开，再次遇到说明组件引用了自己
+    bool done = false;       // 已加入元素表（或已检查）
+};
 
+// 页面中的组件表。<template> 在构造时一次收集，位置不限，先使用后定义也可以；
+// <include> 的文件在第一次引用时解析一次，之后的引用共用同一份树
+class component_table {
+public:
+    explicit component_table(const mkml_node& mkml) {
+        for (const auto& node : mkml.children()) {
+            if (node.tag == ATOM_BODY) collect_templates(node);
+        }
+    }
+    component_table(const component_table&) = delete;
+    component_table& operator=(const component_table&) = delete;
+
+    // <use name> / <include src> 引用的组件，不存在或文件无法读取时返回空
+    mkml_component* find(const mkml_node& ref) {
+        if (ref.tag == ATOM_USE) {
+            auto it = templates.find(ref.attr(ATOM_NAME));
+            return it == templates.end() ? nullptr : &it->second;
+        }
+        if (ref.tag == ATOM_INCLUDE) return load(std::string(ref.attr(ATOM_SRC)));
+        return nullptr;
+    }
 
-// 顶层函数，传入 HTML 字符串返回 mkml_node 树
-inline mkml_node parse_html_to_mkml(const std::string& html) {
-    htmlDocPtr doc = htmlReadMemory(html.c_str(), html.size(), nullptr, nullptr,
-                                     HTML_PARSE_NOERROR | HTML_PARSE_NOWARNING);
-    if (!doc) {
-        std::cerr << "Failed to parse MKML.\n";
-        return {};
+private:
+    void collect_templates(const mkml_node& node) {
+        for (const auto& child : node.children()) {
+            if (child.tag == ATOM_TEMPLATE && child.has_attr(ATOM_NAME)) {
+                std::string name(child.attr(ATOM_NAME));
+                if (templates.count(name) == 0) { // 重名时第一个定义生效
+                    templates[name] = {name, &child};
+                }
+            }
+            collect_templates(child);
+        }
     }
 
-    xmlNode* root = xmlDocGetRootElement(doc);
-    mkml_node tree = build_mkml_tree(root);
+    mkml_component* load(const std::string& path) {
+        auto it = includes.find(path);
+        if (it == includes.end()) {
+            mkml_component component{path, nullptr};
+            if (auto doc = load_mkml_file(path)) {
+                documents.push_back(doc);
+                // 片段没有 <body> 时 libxml2 会补出来
+                for (const auto& node : doc->root->children()) {
+                    if (node.tag == ATOM_BODY) component.node = &node;
+                }
+                if (component.node) collect_templates(*component.node);
+            }
+            it = includes.emplace(path, std::move(component)).first;
+        }
+        return it->second.node ? &it->second : nullptr;
+    }
 
-    xmlFreeDoc(doc);
-    xmlCleanupParser();
+    std::map<std::string, mkml_component, std::less<>> templates;
+    std::map<std::string, mkml_component> includes;
+    std::vector<std::shared_ptr<const mkml_document>> documents; // 被包含的文件，可能与其他页面共用
+};
 
-    return tree;
+inline void collect_includes(const mkml_node& node, std::vector<std::string>& sources,
+                             std::set<std::string>& seen) {
+    for (const auto& child : node.children()) {
+        if (child.tag == ATOM_INCLUDE && child.has_attr(ATOM_SRC)) {
+            std::string src(child.attr(ATOM_SRC));
+            if (!seen.insert(src).second) continue;
+            sources.push_back(src);
+            if (auto doc = load_mkml_file(src)) collect_includes(*doc->root, sources, seen);
+        }
+        collect_includes(child, sources, seen);
+    }
 }
-std::string generate_uuid_var(const std::string& prefix = "var_", size_t length = 12) {
-    static const char charset[] =
-        "abcdefghijklmnopqrstuvwxyz"
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "0123456789";
-    static std::mt19937 rng(std::random_device{}());
-    static std::uniform_int_distribution<> dist(0, sizeof(charset) - 2);
 
-    std::string uuid = prefix;
+// 收集 <style src>/<script src> 与 <include src>（含被包含文件中的 include）
+// 引用的外部文件，用于构建缓存与 mkcc watch
+inline std::vector<std::string> collect_sources(const mkml_node& mkml) {
+    std::vector<std::string> sources;
+    std::set<std::string> seen;
+    for (const auto& node : mkml.children()) {
+        if (node.tag == ATOM_BODY) collect_includes(node, sources, seen);
+        if (node.tag != ATOM_HEAD) continue;
+        for (const auto& child : node.children()) {
+            if (child.tag != ATOM_STYLE && child.tag != ATOM_SCRIPT) continue;
+            if (child.has_attr(ATOM_SRC)) sources.emplace_back(child.attr(ATOM_SRC));
+        }
+    }
+    return sources;
+}
 
-    // 确保首字符是字母或下划线（不能以数字开头）
-    char first = charset[dist(rng)];
-    while ((first >= '0' && first <= '9')) {
-        first = charset[dist(rng)];
+// 选择器 → 样式表下标，与运行时从空表开始 parse_css_style 得到的 styleIndex 相同
+inline std::unordered_map<std::string, uint32_t> css_style_index(const std::vector<css_rule>& rules) {
+    std::unordered_map<std::string, uint32_t> index;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        index.emplace(rules[i].selector, static_cast<uint32_t>(i + 1));
     }
-    uuid += first;
+    return index;
+}
 
-    // 生成剩下的随机字符
-    for (size_t i = 1; i < length; ++i) {
-        uuid += charset[dist(rng)];
+// 把 <body> 展平成元素表：body 区间在最前，之后是各组件的区间，被依赖的组件在前。
+// 每个组件只生成一次，使用处是一个 UI_COMPONENT 元素；元素的样式在这里按层叠规则
+// 解析为样式表下标，运行时不再查找选择器。编译模式与播放器使用同一张表
+class ui_table_builder {
+public:
+    ui_table_builder(const mkml_node& mkml, const std::unordered_map<std::string, uint32_t>& style_index,
+                     ui_document& doc, ui_string_pool& pool)
+        : components(mkml), style_index(style_index), doc(doc), pool(pool) {
+        for (const auto& node : mkml.children()) {
+            if (node.tag == ATOM_BODY) resolve(node);
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            component_index[order[i]] = static_cast<uint32_t>(i);
+        }
+        range_first = static_cast<uint32_t>(doc.elements.size());
+        for (const auto& node : mkml.children()) {
+            if (node.tag == ATOM_BODY) add_children(node, -1);
+        }
+        doc.body = {range_first, static_cast<uint32_t>(doc.elements.size()) - range_first};
+        for (mkml_component* component : order) {
+            range_first = static_cast<uint32_t>(doc.elements.size());
+            add_children(*component->node, -1);
+            doc.components.push_back({range_first, static_cast<uint32_t>(doc.elements.size()) - range_first});
+        }
     }
 
-    return uuid;
-}
-std::string escape_text(const std::string& text) {
-    std::string result;
-    for (char c : text) {
-        if (c == '\n' || c == '\r') {
-            result += ' '; // 将换行替换为空格
-        } else if (c == '"') {
-            result += "\\\""; // 转义双引号
-        } else {
-            result += c;
+private:
+    // parent 为所属 div 相对当前区间起点的下标
+    void add_children(const mkml_node& node, int32_t parent) {
+        for (const auto& child : node.children()) {
+            ui_element e;
+            e.parent = parent;
+            std::string_view style_tag;
+            switch (child.tag) {
+            case ATOM_DIV:
+                e.type = UI_DIV;
+                style_tag = "div";
+                break;
+            case ATOM_P:
+            case ATOM_H1:
+            case ATOM_H2:
+            case ATOM_H3:
+            case ATOM_H4:
+            case ATOM_H5:
+            case ATOM_H6:
+                // 运行时按标签名查找样式：段落与 h1-h6 都是 p
+                e.type = UI_PARAGRAPH;
+                e.font_size = element_font_size(child.tag);
+                style_tag = "p";
+                break;
+            case ATOM_BUTTON:
+                e.type = UI_BUTTON;
+                style_tag = "button";
+                break;
+            case ATOM_USE:
+            case ATOM_INCLUDE: {
+                mkml_component* component = components.find(child);
+                if (!component || !component->done || rejected.count(&child)) continue;
+                e.type = UI_COMPONENT;
+                e.component = component_index[component];
+                doc.elements.push_back(e);
+                continue;
+            }
+            default:
+                continue; // <template> 本身不显示，不支持的标签忽略
+            }
+            std::string_view id = child.attr(ATOM_ID);
+            std::string_view cssclass = child.attr(ATOM_CLASS);
+            css_style_ref style = css_resolve(style_index, style_tag, id, cssclass);
+            e.id = pool.add(id);
+            e.class_name = pool.add(cssclass);
+            e.style = style.normal;
+            e.hover_style = style.hover;
+            if (e.type != UI_DIV) e.text = pool.append(child.content);
+            doc.elements.push_back(e);
+            if (e.type == UI_DIV) add_children(child, static_cast<int32_t>(doc.elements.size() - 1 - range_first));
         }
     }
-    return result;
-}
-void recursion_body_code(
-    mkml_node & node,
-    std::vector<body_code>& body_codes,
-    std::vector<std::string>& div_vars,
-    std::unordered_map<std::string, std::unordered_map<std::string, std::string>*>& div_info_map
-){
-    if (node.name == "div") {
-        std::string var = generate_uuid_var();
-        div_vars.push_back(var);
-        div_info_map[var] = &node.attrs; // 保存 div 的 id/class 等属性指针
-
-        for (auto& child : node.children) {
-            child.note = var;
-            child.parent = &node;
-            recursion_body_code(child, body_codes, div_vars, div_info_map); // 传递 div_info_map
+
+    // 按第一次使用的顺序确定要生成的组件，依赖排在使用者之前。
+    // 找不到的组件与形成循环的引用在这里报告一次，生成时跳过
+    void resolve(const mkml_node& node) {
+        for (const auto& child : node.children()) {
+            if (child.tag == ATOM_TEMPLATE) continue; // 只有被使用的模板才生成
+            if (child.tag != ATOM_USE && child.tag != ATOM_INCLUDE) {
+                resolve(child);
+                continue;
+            }
+            mkml_component* component = components.find(child);
+            if (!component) {
+                if (child.tag == ATOM_USE) std::cerr << "[mkcc] Unknown component: " << child.attr(ATOM_NAME) << "\n";
+                else std::cerr << "[mkcc] Cannot include " << child.attr(ATOM_SRC) << "\n";
+            } else if (component->expanding) {
+                std::cerr << "[mkcc] Component " << component->label << " uses itself, ignored\n";
+                rejected.insert(&child);
+            } else if (!component->done) {
+                component->expanding = true;
+                resolve(*component->node);
+                component->expanding = false;
+                component->done = true;
+                order.push_back(component);
+            }
         }
-    } else if (node.name == "p" || node.name == "h1" || node.name == "h2" || node.name == "h3" ||
-               node.name == "h4" || node.name == "h5" || node.name == "h6" || node.name == "button") {
+    }
 
-        body_code code;
-        code.attrs = node.attrs;
+    component_table components;
+    const std::unordered_map<std::string, uint32_t>& style_index;
+    ui_document& doc;
+    ui_string_pool& pool;
+    std::vector<mkml_component*> order;
+    std::map<mkml_component*, uint32_t> component_index; // 组件在 order 中的位置
+    uint32_t range_first = 0;                           // 正在生成的区间的起点
+    std::set<const mkml_node*> rejected;
+};
 
-        if (node.parent) {
-            code.parent_attrs = &node.parent->attrs;
-        }
+inline void append_color(std::string& out, const css_color& c) {
+    out += "sf::Color(";
+    append_int(out, c.r);
+    out += ", ";
+    append_int(out, c.g);
+    out += ", ";
+    append_int(out, c.b);
+    out += ", ";
+    append_int(out, c.a);
+    out += ")";
+}
 
-        code.parent_var = node.note.empty() ? "rootdiv" : node.note;
+// 构建时解析好的样式表：选择器数组与 Style 数组按下标一一对应，
+// 程序启动时由 load_style_table 载入，不再在运行时解析 CSS。
+// 载入后 mkcc_styles[i] 位于 styleTable[i + 1]，下标 0 是默认样式
+inline void emit_style_table(std::string& out, const std::vector<css_rule>& rules) {
+    if (rules.empty()) return;
+    out += "static const char* const mkcc_style_selectors[] = {\n";
+    for (const auto& rule : rules) {
+        out += "    ";
+        append_literal(out, rule.selector);
+        out += ",\n";
+    }
+    out += "};\nstatic const Style mkcc_styles[] = {\n";
+    for (const auto& rule : rules) {
+        const css_style& style = rule.style;
+        out += "    {";
+        append_color(out, style.background);
+        out += ", ";
+        append_color(out, style.text);
+        out += ", ";
+        append_int(out, static_cast<int>(style.font_size));
+        out += ", ";
+        append_float(out, style.padding);
+        out += ", ";
+        append_float(out, style.border_radius);
+        out += ", ";
+        append_color(out, style.border);
+        out += ", ";
+        append_float(out, style.border_thickness);
+        out += "},\n";
+    }
+    out += "};\n";
+}
 
-        if (node.name == "button") {
-            code.body_type = body_type::Button;
-            code.text = node.content;
-        } else {
-            code.body_type = body_type::Paragraph;
-            code.text = node.content;
-
-            if (node.name == "p")        code.font_size = 16;
-            else if (node.name == "h1") code.font_size = 32;
-            else if (node.name == "h2") code.font_size = 24;
-            else if (node.name == "h3") code.font_size = 19;
-            else if (node.name == "h4") code.font_size = 16;
-            else if (node.name == "h5") code.font_size = 13;
-            else if (node.name == "h6") code.font_size = 11;
-        }
+// ui_str 与 ui_range 都写成 {a, b}
+inline void append_pair(std::string& out, uint32_t a, uint32_t b) {
+    out += '{';
+    append_int(out, static_cast<int>(a));
+    out += ", ";
+    append_int(out, static_cast<int>(b));
+    out += '}';
+}
 
-        body_codes.push_back(code);
+// 元素表与字符串池生成为静态数组，由运行时的 build_ui_table 循环实例化。
+// 每个元素只是一行常量数据，main.cpp 的编译时间几乎不随页面规模增长
+inline void emit_ui_table(std::string& out, const ui_document& table) {
+    if (table.elements.empty()) return;
+    // 分成多段相邻的字面量，避免单个字面量过长；不在 UTF-8 多字节序列中间断开
+    out += "static constexpr char mkcc_ui_strings[] =\n";
+    std::string_view strings(table.strings);
+    do {
+        size_t n = std::min<size_t>(96, strings.size());
+        while (n < strings.size() && (static_cast<unsigned char>(strings[n]) & 0xC0) == 0x80) ++n;
+        out += "    ";
+        append_literal(out, strings.substr(0, n));
+        out += '\n';
+        strings.remove_prefix(n);
+    } while (!strings.empty());
+    out += "    ;\nstatic constexpr ui_element mkcc_ui_elements[] = {\n";
+    for (const auto& e : table.elements) {
+        out += "    {";
+        append_int(out, static_cast<int>(e.type));
+        out += ", ";
+        append_int(out, e.parent);
+        out += ", ";
+        append_int(out, static_cast<int>(e.font_size));
+        out += ", ";
+        append_pair(out, e.text.offset, e.text.length);
+        out += ", ";
+        append_pair(out, e.id.offset, e.id.length);
+        out += ", ";
+        append_pair(out, e.class_name.offset, e.class_name.length);
+        out += ", ";
+        append_int(out, static_cast<int>(e.style));
+        out += ", ";
+        append_int(out, static_cast<int>(e.hover_style));
+        out += ", ";
+        append_int(out, static_cast<int>(e.component));
+        out += "},\n";
     }
+    out += "};\n";
+    if (table.components.empty()) return;
+    out += "static constexpr ui_range mkcc_ui_components[] = {\n";
+    for (const auto& range : table.components) {
+        out += "    ";
+        append_pair(out, range.first, range.count);
+        out += ",\n";
+    }
+    out += "};\n";
 }
-std::string sanitize_key(const std::string& key) {
-    std::string result = key;
-    for (char& c : result) {
-        if (c == '-') c = '_';
+
+// main.cpp 模板。生成的代码插入在 /*start*/ 等标记行之后；模板只在加载时
+// 按标记切分一次，生成时各段与生成内容依次追加到同一个缓冲区
+struct main_template {
+    enum section { heads, scripts, body, scripts_list };
+    struct insertion {
+        size_t offset;   // 标记行之后的位置
+        section what;
+    };
+
+    std::string source;
+    std::vector<insertion> insertions; // 按 offset 递增
+
+    explicit main_template(std::string text) : source(std::move(text)) {
+        static const std::pair<std::string_view, section> markers[] = {
+            {"/*start*/", heads},
+            {"/*script*/", scripts},
+            {"/*body_start*/", body},
+            {"/*scripts_start*/", scripts_list}};
+        std::string_view view(source);
+        for (size_t pos = 0; pos < view.size();) {
+            size_t end = view.find('\n', pos);
+            size_t next = end == std::string_view::npos ? view.size() : end + 1;
+            std::string_view line = view.substr(pos, next - pos);
+            if (!line.empty() && line.back() == '\n') line.remove_suffix(1);
+            for (const auto& [marker, what] : markers) {
+                if (line == marker) insertions.push_back({next, what});
+            }
+            pos = next;
+        }
     }
-    return result;
+};
+
+// 同一路径的模板在进程内只读取并切分一次；返回的引用一直有效。
+// mkcc serve 中模板文件变化后重新加载，旧的模板保留到进程退出
+inline const main_template& load_main_template(const std::string& path) {
+    struct cached_template {
+        file_stamp stamp;
+        std::unique_ptr<main_template> tmpl;
+    };
+    static std::mutex mutex;
+    static std::map<std::string, cached_template> cache;
+    static std::vector<std::unique_ptr<main_template>> retired;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = cache[path];
+    file_stamp stamp = !entry.tmpl || file_caches_enabled ? stat_file(path) : entry.stamp;
+    if (entry.tmpl && stamp != entry.stamp) retired.push_back(std::move(entry.tmpl));
+    if (!entry.tmpl) {
+        entry.stamp = stamp;
+        entry.tmpl = std::make_unique<main_template>(read_file(path));
+    }
+    return *entry.tmpl;
 }
-void compile(mkml_node& mkml, const std::string& maincpp_path) {
+
+// 一个生成的翻译单元，file 为相对构建目录的文件名
+struct generated_unit {
+    std::string file;
+    std::string source;
+};
+// 根据 main.cpp 模板生成 UI 翻译单元，每个 <script> 另外生成一个翻译单元，
+// 不触碰磁盘上的输出文件。main.cpp 总是第一个
+inline std::vector<generated_unit> generate_units(const mkml_node& mkml, const main_template& tmpl) {
     std::string heads = "";
-    std::unordered_map<std::string, std::string> heads_tag;
-    std::vector<body_code> body_codes;
-    std::vector<std::string> div_vars;
-    std::unordered_map<std::string, std::unordered_map<std::string, std::string>*> div_info_map;
+    std::map<std::string, std::string> heads_tag; // 有序，保证宏的输出顺序稳定
     std::string css;
-    std::unordered_map<std::string, std::string> scripts;
+    std::vector<std::pair<std::string, std::string_view>> scripts; // 按文档顺序
+    std::vector<mapped_file> sources; // <style src>/<script src>，视图在生成结束前有效
     // 提取 <head> 中的宏定义内容
-    for (auto& node : mkml.children) {
-        if (node.name == "head") {
-            for (auto& child : node.children) {
-                if (child.name == "style") {
-                    
-                    std::string style_text=child.content;
-                    if (child.attrs.find("src") != child.attrs.end()){
-                        style_text=read_file(child.attrs["src"]);
+    for (const auto& node : mkml.children()) {
+        if (node.tag == ATOM_HEAD) {
+            for (const auto& child : node.children()) {
+                switch (child.tag) {
+                case ATOM_STYLE: {
+                    std::string_view style_text = child.content;
+                    if (child.has_attr(ATOM_SRC)){
+                        sources.emplace_back(std::string(child.attr(ATOM_SRC)));
+                        style_text = sources.back().view();
                     }
-                    css.append(style_text + "\n");
-                    
-                    continue;
+                    css.append(style_text);
+                    css.append("\n");
+                    break;
                 }
-                if (child.name == "script"){
-                    std::string code_text=child.content;
-                    if (child.attrs.find("src") != child.attrs.end()){
-                        code_text=read_file(child.attrs["src"]);
+                case ATOM_SCRIPT: {
+                    std::string_view code_text = child.content;
+                    if (child.has_attr(ATOM_SRC)){
+                        sources.emplace_back(std::string(child.attr(ATOM_SRC)));
+                        code_text = sources.back().view();
                     }
-                    std::string name= generate_uuid_var("class");
-                    scripts[name]=code_text;
-                    continue;
+                    std::string name= "class_script_" + std::to_string(scripts.size());
+                    scripts.emplace_back(name, code_text);
+                    break;
+                }
+                default: {
+                    std::string name(child.name);
+                    heads_tag[name] = std::string(child.content);
+                    for (const auto& attr : child.attributes()) {
+                        heads_tag[name + "_" + std::string(attr.name)] = std::string(attr.value);
+                    }
+                    break;
                 }
-
-                heads_tag[child.name] = child.content;
-                
-                
-                for (const auto& attr : child.attrs) {
-                    heads_tag[child.name + "_" + attr.first] = attr.second;
                 }
-            }
-        } else if (node.name == "body") {
-            for (auto& child : node.children) {
-                child.note = "rootdiv";
-                recursion_body_code(child, body_codes, div_vars, div_info_map);
             }
         }
     }
 
-    // 生成宏定义字符串
+    // 生成宏定义字符串，main.cpp 与各脚本翻译单元共用
     for (const auto& pair : heads_tag) {
-        std::string code = "#define MKML" + sanitize_key(pair.first) + " \"" + pair.second + "\"\n";
-        heads.append(code);
+        heads += "#define MKML";
+        heads += sanitize_key(pair.first);
+        heads += ' ';
+        append_literal(heads, pair.second);
+        heads += '\n';
     }
-    std::string scripts_code="\n";
-    std::string scripts_list_code="\n";
-    //Script
+    std::vector<generated_unit> units(1);
+    //Script：main.cpp 只声明工厂函数，类本身放在各自的翻译单元里
     for (const auto& [key, value] : scripts) {
-        std::string code = "\nclass "+key+" : public script {\npublic:\n    using script::script;\n"+value+"};\n";
-        scripts_code.append(code);
-        code="scripts_list.emplace_back(create_script<"+key+">(rootdiv));\n";
-        scripts_list_code.append(code);
-    }
-
-    // 将 body_codes 分类到每个 div 下
-
-    std::unordered_map<std::string, std::vector<body_code>> div_map;
-    for (const auto& code : body_codes) {
-        div_map[code.parent_var].push_back(code);
+        std::string code = "#include \"include/div.h\"\n#include \"include/font.h\"\n#include \"include/script.h\"\n\n";
+        code += heads;
+        code += "\nclass "+key+" : public script {\npublic:\n    using script::script;\n";
+        code += value;
+        code += "};\n";
+        code += "\nstd::unique_ptr<script> mkcc_create_" + key + "(Div& root) {\n    return create_script<" + key + ">(root);\n}\n";
+        units.push_back({key + ".cpp", std::move(code)});
     }
 
-    // 构建 UI 构造代码
-    std::ostringstream body_code_out;
-    body_code_out << "// Auto-generated UI build code\n";
-    body_code_out<<"std::string css = R\"("<<css<<")\";\n"<<"parse_css_style(css);\n";
-
-
-    // rootdiv 部分（段落和按钮）
-    for (const auto& code : div_map["rootdiv"]) {
-        std::string id = "";
-        std::string cssclass = "";
-
-        auto it = code.attrs.find("id");
-        if (it != code.attrs.end()) id = it->second;
-        it = code.attrs.find("class");
-        if (it != code.attrs.end()) cssclass = it->second;
-
-        if (code.body_type == body_type::Paragraph) {
-            body_code_out << "rootdiv.addParagraph(\"" << escape_text(code.text)
-                          << "\", font, " << code.font_size
-                          << ", \"" << id << "\", \"" << cssclass << "\");\n";
-        } else if (code.body_type == body_type::Button) {
-            body_code_out << "rootdiv.addButton(\"" << escape_text(code.text) << "\", font, "
-                          << " \"" << id << "\", \"" << cssclass << "\");\n";
-        }
-    }
-
-    // 子 div 声明与填充
-    for (const auto& pair : div_map) {
-        const std::string& var = pair.first;
-        if (var == "rootdiv") continue;
-
-        std::string id = "";
-        std::string cssclass = "";
-        auto* attrs_ptr = div_info_map[var];
-        if (attrs_ptr) {
-            auto it = attrs_ptr->find("id");
-            if (it != attrs_ptr->end()) id = it->second;
-            it = attrs_ptr->find("class");
-            if (it != attrs_ptr->end()) cssclass = it->second;
-        }
-
-        body_code_out << "Div " << var << "(10, 0, \"" << id << "\", \"" << cssclass << "\");\n";
-
-        for (const auto& code : pair.second) {
-            if (code.body_type == body_type::Paragraph) {
-            body_code_out << "rootdiv.addParagraph(\"" << escape_text(code.text)
-                          << "\", font, " << code.font_size
-                          << ", \"" << id << "\", \"" << cssclass << "\");\n";
-            } else if (code.body_type == body_type::Button) {
-                body_code_out << "rootdiv.addButton(\"" << escape_text(code.text) << "\", font, "
-                              << " \"" << id << "\", \"" << cssclass << "\");\n";
+    std::vector<css_rule> style_rules = parse_css(css);
+    std::unordered_map<std::string, uint32_t> style_index = css_style_index(style_rules);
+    ui_document table;
+    ui_string_pool pool(table.strings);
+    ui_table_builder builder(mkml, style_index, table, pool);
+
+    // 模板各段与生成的代码按顺序流式写入同一个缓冲区
+    std::string& out = units[0].source;
+    units[0].file = "main.cpp";
+    out.reserve(tmpl.source.size() + heads.size() + css.size() + table.strings.size() +
+                table.elements.size() * 80 + 4096);
+    size_t copied = 0;
+    for (const auto& insertion : tmpl.insertions) {
+        out.append(tmpl.source, copied, insertion.offset - copied);
+        copied = insertion.offset;
+        switch (insertion.what) {
+        case main_template::heads:
+            out += heads;
+            break;
+        case main_template::scripts:
+            out += '\n';
+            for (const auto& script : scripts) {
+                out += "std::unique_ptr<script> mkcc_create_";
+                out += script.first;
+                out += "(Div& root);\n";
+            }
+            emit_style_table(out, style_rules);
+            emit_ui_table(out, table);
+            break;
+        case main_template::body:
+            // 生成的样式下标只对这份样式表有效，句柄记下它的 generation
+            out += "// Auto-generated UI build code\n";
+            out += "const unsigned mkcc_style_generation = ";
+            if (!style_rules.empty()) {
+                out += "load_style_table(mkcc_style_selectors, mkcc_styles, ";
+                append_int(out, static_cast<int>(style_rules.size()));
+                out += ");\n";
+            } else {
+                out += "load_style_table(nullptr, nullptr, 0);\n";
+            }
+            out += "rootdiv.styleRef = StyleHandle(";
+            append_style_ref(out, css_resolve(style_index, "div", "", ""));
+            out += ", mkcc_style_generation);\n";
+            if (!table.elements.empty()) {
+                out += "build_ui_table(rootdiv, mkcc_ui_elements, ";
+                append_pair(out, table.body.first, table.body.count);
+                out += table.components.empty()
+                           ? ", mkcc_ui_strings, nullptr, font, mkcc_style_generation);\n"
+                           : ", mkcc_ui_strings, mkcc_ui_components, font, mkcc_style_generation);\n";
             }
+            break;
+        case main_template::scripts_list:
+            out += '\n';
+            for (const auto& script : scripts) {
+                out += "scripts_list.emplace_back(mkcc_create_";
+                out += script.first;
+                out += "(rootdiv));\n";
+            }
+            break;
         }
-        body_code_out << "rootdiv.addChild(std::move(" << var << "));\n";
     }
-
-    // 注入 main.cpp
-    std::ifstream infile(maincpp_path);
-    if (!infile.is_open()) {
+    out.append(tmpl.source, copied, std::string::npos);
+    return units;
+}
+inline void compile(const mkml_node& mkml, const std::string& maincpp_path) {
+    mapped_file template_file(maincpp_path);
+    if (!template_file) {
         std::cerr << "[mkcc] Cannot open main.cpp for injection: " << maincpp_path << "\n";
         return;
     }
+    // 输出会覆盖模板本身，因此不使用 load_main_template 的缓存
+    main_template tmpl{std::string(template_file.view())};
+
+    std::string dir = maincpp_path.substr(0, maincpp_path.find_last_of("/\\") + 1);
+    for (const auto& unit : generate_units(mkml, tmpl)) {
+        std::string path = unit.file == "main.cpp" ? maincpp_path : dir + unit.file;
+        write_file(path, unit.source);
+        std::cout << "[mkcc] File generated " << path << "\n";
+    }
+}
 
-    std::ostringstream new_main;
-    std::string line;
-    while (std::getline(infile, line)) {
-        new_main << line << "\n";
-        if (line == "/*start*/") {
-            new_main << heads;
-        }
-        if (line == "/*script*/") {
-            new_main << scripts_code;
+// 所有 <script> 代码（含 src 文件内容）拼接的结果，用于判断脚本是否变化
+inline std::string scripts_fingerprint(const mkml_node& mkml) {
+    std::string out;
+    for (const auto& node : mkml.children()) {
+        if (node.tag != ATOM_HEAD) continue;
+        for (const auto& child : node.children()) {
+            if (child.tag != ATOM_SCRIPT) continue;
+            if (child.has_attr(ATOM_SRC)) out += mapped_file(std::string(child.attr(ATOM_SRC))).view();
+            else out += child.content;
+            out += '\0';
         }
-        if (line == "/*body_start*/") {
-            new_main << body_code_out.str();
+    }
+    return out;
+}
+inline bool uses_scripts(const mkml_node& mkml) {
+    for (const auto& node : mkml.children()) {
+        if (node.tag != ATOM_HEAD) continue;
+        for (const auto& child : node.children()) {
+            if (child.tag == ATOM_SCRIPT) return true;
         }
-        if (line == "/*scripts_start*/") {
-            new_main << scripts_list_code;
+    }
+    return false;
+}
+
+// 将 mkml 树转换为播放器使用的 UI 描述，<head> 的处理与 compile() 一致
+inline ui_document build_ui_document(const mkml_node& mkml) {
+    ui_document doc;
+    ui_string_pool pool(doc.strings);
+    std::map<std::string, std::string> heads_tag;
+    std::string css;
+
+    for (const auto& node : mkml.children()) {
+        if (node.tag == ATOM_HEAD) {
+            for (const auto& child : node.children()) {
+                if (child.tag == ATOM_SCRIPT) continue;
+                if (child.tag == ATOM_STYLE) {
+                    if (child.has_attr(ATOM_SRC)) css.append(mapped_file(std::string(child.attr(ATOM_SRC))).view());
+                    else css.append(child.content);
+                    css.append("\n");
+                    continue;
+                }
+                std::string name(child.name);
+                heads_tag[name] = std::string(child.content);
+                for (const auto& attr : child.attributes()) {
+                    heads_tag[name + "_" + std::string(attr.name)] = std::string(attr.value);
+                }
+            }
         }
     }
-    infile.close();
+    // 样式下标按播放器从空表解析 css 的结果计算
+    std::unordered_map<std::string, uint32_t> style_index = css_style_index(parse_css(css));
+    ui_table_builder builder(mkml, style_index, doc, pool);
 
-    write_file(maincpp_path, new_main.str());
-    std::cout << "[mkcc] File generated " << maincpp_path << "\n";
+    for (const auto& [key, value] : heads_tag) {
+        doc.heads.push_back({pool.add(sanitize_key(key)), pool.add(value)});
+    }
+    doc.css = pool.append(css);
+    return doc;
 }
@@ -0,0 +1,252 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "trace.h"
+
+// 只有 mkcc serve 打开：按 file_stamp 在进程内复用文件哈希、解析结果与诊断。
+// 一次性的命令每个文件只处理一次，缓存没有意义
+inline std::atomic<bool> file_caches_enabled{false};
+
+// 只读映射输入文件（MKML、CSS、脚本、模板），内容以 string_view 交给解析器与
+// 生成器，不再经过 ifstream → ostringstream → std::string 的两次复制。
+// 映射在对象析构时解除，view() 不能比对象活得更久。
+// 没有 mmap 的平台退回一次性读入；mkcc serve 中也一次性读入，见 open
+class mapped_file
+{
+public:
+  mapped_file() = default;
+  explicit mapped_file(const std::string& path) { open(path); }
+  ~mapped_file() { close(); }
+
+  mapped_file(mapped_file&& other) noexcept { *this = std::move(other); }
+  mapped_file& operator=(mapped_file&& other) noexcept
+  {
+    if (this == &other) return *this;
+    close();
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    std::swap(opened, other.opened);
+    std::swap(mapped, other.mapped);
+    buffer = std::move(other.buffer);
+    if (opened && !mapped) data = buffer.data();
+    return *this;
+  }
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  // 文件不存在或无法读取时返回 false；空文件可以打开，内容为空
+  bool open(const std::string& path)
+  {
+    close();
+    trace_span span(path, "read");
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+      ::close(fd);
+      return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    if (size > 0 && file_caches_enabled)
+    {
+      // 常驻的 mkcc serve 不映射：文件在映射期间被截断（编辑器保存、git
+      // checkout）时访问超出部分会触发 SIGBUS，让整个守护进程退出。
+      // 读到的长度以 read 的结果为准
+      buffer.resize(size);
+      size_t got = 0;
+      while (got < size)
+      {
+        ssize_t n = ::read(fd, buffer.data() + got, size - got);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0)
+        {
+          ::close(fd);
+          buffer.clear();
+          size = 0;
+          return false;
+        }
+        if (n == 0) break;
+        got += static_cast<size_t>(n);
+      }
+      buffer.resize(got);
+      data = buffer.data();
+      size = got;
+    }
+    else if (size > 0)
+    {
+      void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED)
+      {
+        ::close(fd);
+        size = 0;
+        return false;
+      }
+      madvise(p, size, MADV_SEQUENTIAL);  // 解析器从头到尾顺序读取
+      data = static_cast<const char*>(p);
+      mapped = true;
+    }
+    ::close(fd);  // 映射不依赖文件描述符
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    buffer = ss.str();
+    data = buffer.data();
+    size = buffer.size();
+#endif
+    opened = true;
+    return true;
+  }
+
+  explicit operator bool() const { return opened; }
+  std::string_view view() const { return {data, size}; }
+
+private:
+  void close()
+  {
+#ifndef _WIN32
+    if (mapped) munmap(const_cast<char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+    opened = false;
+    mapped = false;
+    buffer.clear();
+  }
+
+  const char* data = nullptr;
+  size_t size = 0;
+  bool opened = false;
+  bool mapped = false;
+  std::string buffer;  // 不使用 mmap 时持有内容
+};
+
+// 整个缓冲区一次写出：生成的源码已经完整地在内存中，用一次 write 代替
+// ofstream 的分块写入。失败时返回 false
+inline bool write_whole_file(const std::string& path, std::string_view content)
+{
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+  const char* p = content.data();
+  size_t left = content.size();
+  while (left > 0)
+  {
+    ssize_t n = ::write(fd, p, left);  // 通常一次写完，被信号打断时继续
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      ::close(fd);
+      return false;
+    }
+    p += n;
+    left -= static_cast<size_t>(n);
+  }
+  return ::close(fd) == 0;
+#else
+  std::ofstream file(path, std::ios::binary);
+  if (!file) return false;
+  file.write(content.data(), static_cast<std::streamsize>(content.size()));
+  return static_cast<bool>(file);
+#endif
+}
+
+// 文件的修改时间与大小。mkcc serve 常驻内存，用它判断缓存的哈希、解析结果与
+// 诊断是否仍对应磁盘上的文件；文件不存在时 size 为 -1
+struct file_stamp
+{
+  int64_t mtime = 0;
+  int64_t size = -1;
+
+  bool operator==(const file_stamp& other) const
+  {
+    return mtime == other.mtime && size == other.size;
+  }
+  bool operator!=(const file_stamp& other) const { return !(*this == other); }
+};
+
+inline file_stamp stat_file(const std::string& path)
+{
+  std::error_code ec;
+  auto size = std::filesystem::file_size(path, ec);
+  if (ec) return {};
+  auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) return {};
+  return {static_cast<int64_t>(mtime.time_since_epoch().count()),
+          static_cast<int64_t>(size)};
+}
+
+// 单个缓存的条目数上限，超过时整体清空
+inline constexpr size_t FILE_CACHE_LIMIT = 4096;
+
+namespace file_cache_detail
+{
+inline std::mutex mutex;
+inline std::vector<std::function<void()>> pruners;
+}  // namespace file_cache_detail
+
+// 常驻进程中按文件缓存的结果。键以文件的绝对路径开头，之后可以跟 '\0' 与
+// 其他内容。mkcc serve 在每个请求之后调用 prune_file_caches：文件已不存在
+// （删除或改名）的条目被删除，条目过多时整体清空，内存不会随时间无限增长
+template <typename Value>
+struct file_cache
+{
+  std::mutex mutex;
+  std::unordered_map<std::string, Value> entries;
+
+  file_cache()
+  {
+    std::lock_guard<std::mutex> lock(file_cache_detail::mutex);
+    file_cache_detail::pruners.push_back([this] { prune(); });
+  }
+  file_cache(const file_cache&) = delete;
+  file_cache& operator=(const file_cache&) = delete;
+
+  void prune()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.size() > FILE_CACHE_LIMIT)
+    {
+      entries.clear();
+      return;
+    }
+    for (auto it = entries.begin(); it != entries.end();)
+    {
+      std::error_code ec;
+      std::string path = it->first.substr(0, it->first.find('\0'));
+      if (std::filesystem::exists(path, ec) || ec)
+        ++it;
+      else
+        it = entries.erase(it);
+    }
+  }
+};
+
+// 不能与缓存的读写同时调用；mkcc serve 在两个请求之间调用
+inline void prune_file_caches()
+{
+  std::lock_guard<std::mutex> lock(file_cache_detail::mutex);
+  for (const auto& prune : file_cache_detail::pruners) prune();
+}
@@ -0,0 +1,232 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 编译器一侧的 MKML 树。节点、属性数组与文本都分配在所属文档的 arena 中，
+// 随文档一次性释放；标签名与属性名驻留为整数 atom，分派时用 switch 代替字符串比较
+
+// 按块分配的 bump 分配器，只分配不单独释放，放入其中的对象不会被析构
+class mkml_arena
+{
+public:
+  mkml_arena() = default;
+  mkml_arena(mkml_arena&&) = default;
+  mkml_arena& operator=(mkml_arena&&) = default;
+  mkml_arena(const mkml_arena&) = delete;
+  mkml_arena& operator=(const mkml_arena&) = delete;
+
+  void* allocate(size_t size, size_t align)
+  {
+    size_t offset = (used + align - 1) & ~(align - 1);
+    if (blocks.empty() || offset + size > capacity)
+    {
+      // 超过块大小的请求单独占一块
+      capacity = std::max(block_size, size);
+      blocks.emplace_back(new char[capacity]);
+      reserved += capacity;
+      offset = 0;
+    }
+    used = offset + size;
+    return blocks.back().get() + offset;
+  }
+
+  template <typename T, typename... Args>
+  T* create(Args&&... args)
+  {
+    return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+  }
+
+  std::string_view copy(std::string_view text)
+  {
+    if (text.empty()) return {};
+    char* p = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(p, text.data(), text.size());
+    return {p, text.size()};
+  }
+
+  // 已向系统申请的字节数
+  size_t bytes_reserved() const { return reserved; }
+
+private:
+  static constexpr size_t block_size = 64 * 1024;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  size_t used = 0;
+  size_t capacity = 0;
+  size_t reserved = 0;
+};
+
+// 编译器认识的标签与属性名；其他名字在解析时按文档动态分配 atom
+enum mkml_atom : uint32_t
+{
+  ATOM_NONE = 0,
+  ATOM_HTML,
+  ATOM_HEAD,
+  ATOM_BODY,
+  ATOM_TITLE,
+  ATOM_SIZE,
+  ATOM_STYLE,
+  ATOM_SCRIPT,
+  ATOM_DIV,
+  ATOM_P,
+  ATOM_H1,
+  ATOM_H2,
+  ATOM_H3,
+  ATOM_H4,
+  ATOM_H5,
+  ATOM_H6,
+  ATOM_BUTTON,
+  ATOM_ID,
+  ATOM_CLASS,
+  ATOM_SRC,
+  ATOM_TEMPLATE,
+  ATOM_USE,
+  ATOM_INCLUDE,
+  ATOM_NAME,
+  ATOM_BUILTIN_COUNT
+};
+
+// 与 mkml_atom 的顺序一一对应
+inline constexpr std::string_view mkml_builtin_atoms[ATOM_BUILTIN_COUNT] = {
+    "",   "html", "head", "body", "title",  "size", "style",
+    "script", "div", "p",  "h1",   "h2",  "h3",   "h4",
+    "h5", "h6",   "button", "id", "class", "src", "template",
+    "use", "include", "name"};
+
+inline mkml_atom builtin_atom(std::string_view name)
+{
+  static const std::unordered_map<std::string_view, mkml_atom> table = []
+  {
+    std::unordered_map<std::string_view, mkml_atom> t;
+    for (uint32_t i = 1; i < ATOM_BUILTIN_COUNT; ++i)
+      t.emplace(mkml_builtin_atoms[i], static_cast<mkml_atom>(i));
+    return t;
+  }();
+  auto it = table.find(name);
+  return it == table.end() ? ATOM_NONE : it->second;
+}
+
+struct mkml_attr
+{
+  mkml_atom key;
+  std::string_view name;
+  std::string_view value;
+};
+
+struct mkml_node
+{
+  mkml_atom tag = ATOM_NONE;
+  std::string_view name;     // 节点名，例如 head、title、body
+  std::string_view content;  // 直属文本内容
+  const mkml_attr* attrs = nullptr;
+  uint32_t attr_count = 0;
+  int line = 0;              // 起始标签所在行，用于诊断
+  mkml_node* parent = nullptr;
+  mkml_node* first_child = nullptr;
+  mkml_node* next_sibling = nullptr;
+
+  // 属性不存在时返回空串
+  std::string_view attr(mkml_atom key) const
+  {
+    for (uint32_t i = 0; i < attr_count; ++i)
+    {
+      if (attrs[i].key == key) return attrs[i].value;
+    }
+    return {};
+  }
+
+  bool has_attr(mkml_atom key) const
+  {
+    for (uint32_t i = 0; i < attr_count; ++i)
+    {
+      if (attrs[i].key == key) return true;
+    }
+    return false;
+  }
+
+  struct attr_range
+  {
+    const mkml_attr* first;
+    const mkml_attr* last;
+    const mkml_attr* begin() const { return first; }
+    const mkml_attr* end() const { return last; }
+  };
+
+  attr_range attributes() const { return {attrs, attrs + attr_count}; }
+
+  class child_iterator
+  {
+  public:
+    explicit child_iterator(const mkml_node* n) : node(n) {}
+    const mkml_node& operator*() const { return *node; }
+    const mkml_node* operator->() const { return node; }
+    child_iterator& operator++()
+    {
+      node = node->next_sibling;
+      return *this;
+    }
+    bool operator!=(const child_iterator& other) const
+    {
+      return node != other.node;
+    }
+
+  private:
+    const mkml_node* node;
+  };
+
+  struct child_range
+  {
+    const mkml_node* first;
+    child_iterator begin() const { return child_iterator(first); }
+    child_iterator end() const { return child_iterator(nullptr); }
+  };
+
+  child_range children() const { return {first_child}; }
+};
+
+// 解析得到的文档，拥有整棵树的内存。只能移动；移动后节点地址不变
+class mkml_document
+{
+public:
+  mkml_document() : root(arena.create<mkml_node>()) {}
+  mkml_document(mkml_document&&) = default;
+  mkml_document& operator=(mkml_document&&) = default;
+  mkml_document(const mkml_document&) = delete;
+  mkml_document& operator=(const mkml_document&) = delete;
+
+  mkml_arena arena;
+  mkml_node* root;  // 解析失败时为没有名字的空节点
+
+  // 返回名字对应的 atom，name_out 指向驻留的名字（内置名或 arena 中的副本）
+  mkml_atom intern(std::string_view name, std::string_view& name_out)
+  {
+    mkml_atom atom = builtin_atom(name);
+    if (atom != ATOM_NONE)
+    {
+      name_out = mkml_builtin_atoms[atom];
+      return atom;
+    }
+    auto it = dynamic_atoms.find(name);
+    if (it == dynamic_atoms.end())
+    {
+      std::string_view stored = arena.copy(name);
+      it = dynamic_atoms
+               .emplace(stored, static_cast<mkml_atom>(ATOM_BUILTIN_COUNT +
+                                                      dynamic_atoms.size()))
+               .first;
+    }
+    name_out = it->first;
+    return it->second;
+  }
+
+private:
+  std::unordered_map<std::string_view, mkml_atom> dynamic_atoms;
+};
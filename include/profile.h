@@ -0,0 +1,150 @@
+#pragma once
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// 构建配置档（mkccmake.json 的 "profiles"），决定编译器、优化级别与链接方式
+//
+//   "profile": "debug",
+//   "profiles": {
+//     "release": { "optimization": "3", "march": "native", "lto": true }
+//   }
+//
+// debug 与 release 有内置默认值，配置文件中的字段覆盖默认值；其他名字为自定义配置档
+
+enum class pgo_stage
+{
+  none,
+  generate,  // 插桩构建，运行时写出 profile 数据
+  use        // 使用训练得到的 profile 数据重新构建
+};
+
+// 安装时由 CMake 预编译的 libmkccrt.a 旁边有 libmkccrt.key，第一行是编译器
+// 种类（CMAKE_CXX_COMPILER_ID）。同一种编译器不同 -O 级别的目标文件可以
+// 链接在一起，因此只要种类一致就复用它；否则由 ensure_runtime_library 按本次
+// 的编译器与参数另外编译一份
+inline bool prebuilt_runtime_matches(const std::string& key,
+                                     const std::string& compiler)
+{
+  bool clang = compiler.find("clang") != std::string::npos;
+  return key.substr(0, key.find('\n')) == (clang ? "Clang" : "GNU");
+}
+
+struct build_profile
+{
+  std::string name = "debug";
+  std::string compiler = "g++";
+  std::string optimization = "0";    // -O 后的部分：0/1/2/3/s/fast
+  std::string march;                 // 为空时不指定 -march
+  bool lto = false;
+  bool static_sfml = false;
+  std::vector<std::string> flags;    // 额外的编译参数
+  std::vector<std::string> ldflags;  // 额外的链接参数
+
+  // PGO 阶段与 profile 数据目录，由 mkcc release --pgo 设置
+  pgo_stage pgo = pgo_stage::none;
+  std::string pgo_dir;
+
+  bool is_clang() const
+  {
+    return compiler.find("clang") != std::string::npos;
+  }
+
+  // 用于区分目标文件目录与缓存的名字。PGO 的两个阶段必须共用同一目标文件路径，
+  // gcc 按目标文件路径查找对应的 .gcda
+  std::string variant() const
+  {
+    return pgo == pgo_stage::none ? name : name + "-pgo";
+  }
+
+  // 编译与链接共用的参数（-flto、PGO 参数在两个阶段都必须出现）
+  std::string compile_flags() const
+  {
+    std::string out = "-std=c++17 -O" + optimization;
+    if (!march.empty()) out += " -march=" + march;
+    if (lto) out += is_clang() ? " -flto" : " -flto=auto";
+    if (static_sfml) out += " -DSFML_STATIC";
+    if (pgo == pgo_stage::generate)
+    {
+      out += " -fprofile-generate=\"" + pgo_dir + "\"";
+    }
+    else if (pgo == pgo_stage::use)
+    {
+      out += is_clang()
+                 ? " -fprofile-use=\"" + pgo_dir + "/default.profdata\""
+                 : " -fprofile-use=\"" + pgo_dir +
+                       "\" -fprofile-correction -Wno-missing-profile";
+    }
+    for (const auto& f : flags) out += " " + f;
+    return out;
+  }
+
+  std::string link_flags() const
+  {
+    std::string out;
+    for (const auto& f : ldflags) out += " " + f;
+    if (!static_sfml)
+    {
+      return out + " -lsfml-graphics -lsfml-window -lsfml-system";
+    }
+    // 静态 SFML 需要显式链接它依赖的系统库
+    out += " -lsfml-graphics-s -lsfml-window-s -lsfml-system-s";
+#ifdef _WIN32
+    out += " -lopengl32 -lwinmm -lgdi32 -lfreetype";
+#elif defined(__APPLE__)
+    out += " -framework OpenGL -framework AppKit -framework IOKit"
+           " -framework Carbon -lfreetype";
+#else
+    out += " -lGL -lX11 -lXrandr -lXcursor -ludev -lfreetype -lpthread";
+#endif
+    return out;
+  }
+
+  // 运行时可以单独编译成静态库再链接；LTO、PGO 与静态 SFML 需要运行时
+  // 用项目的参数一起编译
+  bool can_link_runtime_library() const
+  {
+    return !lto && !static_sfml && pgo == pgo_stage::none;
+  }
+
+  // key 为预编译运行时旁 libmkccrt.key 的内容，见 prebuilt_runtime_matches
+  bool can_use_prebuilt_runtime(const std::string& key) const
+  {
+    return can_link_runtime_library() && prebuilt_runtime_matches(key, compiler);
+  }
+};
+
+inline build_profile load_build_profile(const nlohmann::json& config,
+                                        const std::string& name)
+{
+  build_profile profile;
+  profile.name = name;
+  if (name == "debug")
+  {
+    profile.flags = {"-g"};
+  }
+  else if (name == "release")
+  {
+    profile.optimization = "2";
+    profile.lto = true;
+    profile.flags = {"-DNDEBUG"};
+  }
+
+  if (!config.contains("profiles") || !config["profiles"].contains(name))
+  {
+    return profile;
+  }
+  const auto& p = config["profiles"][name];
+  profile.compiler = p.value("compiler", profile.compiler);
+  profile.optimization = p.value("optimization", profile.optimization);
+  if (profile.optimization.rfind("-O", 0) == 0)
+  {
+    profile.optimization = profile.optimization.substr(2);
+  }
+  profile.march = p.value("march", profile.march);
+  profile.lto = p.value("lto", profile.lto);
+  profile.static_sfml = p.value("static_sfml", profile.static_sfml);
+  profile.flags = p.value("flags", profile.flags);
+  profile.ldflags = p.value("ldflags", profile.ldflags);
+  return profile;
+}
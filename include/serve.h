@@ -0,0 +1,266 @@
+#pragma once
+// mkcc serve：常驻的构建守护进程与它的客户端，通过项目目录下的 Unix 套接字
+// .mkcc/serve.sock 通信。守护进程只初始化一次 libxml2，并按 file_stamp 在内存中
+// 保留文件哈希、解析结果与诊断，重复的 make/check 只处理变化了的文件。
+// 每个请求之后清理这些缓存（见 file_cache）。
+//
+// 协议：客户端发送若干以 '\0' 结尾的字段（工作目录，之后是命令及其参数），
+// 以一个空字段结束。守护进程把请求期间的 stdout/stderr（包括编译器子进程的
+// 输出）直接写回连接，最后发送 '\0' 与十进制的退出码。仅支持 Linux
+#ifdef __linux__
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+inline const char* const SERVE_SOCKET = ".mkcc/serve.sock";
+
+inline bool serve_write_all(int fd, const char* data, size_t size)
+{
+  while (size > 0)
+  {
+    ssize_t n = ::write(fd, data, size);
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+inline bool serve_address(const std::string& path, sockaddr_un& addr)
+{
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) return false;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+// 读取一个请求：各字段以 '\0' 结尾，空字段表示结束
+inline bool serve_read_request(int fd, std::vector<std::string>& fields)
+{
+  std::string field;
+  char buffer[4096];
+  while (true)
+  {
+    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    for (ssize_t i = 0; i < n; ++i)
+    {
+      if (buffer[i] != '\0')
+      {
+        field += buffer[i];
+        continue;
+      }
+      if (field.empty()) return !fields.empty();
+      fields.push_back(std::move(field));
+      field.clear();
+    }
+  }
+}
+
+// 转发给正在运行的守护进程。连接不上时 connected 为 false，调用方自行处理；
+// 否则把守护进程的输出写到 stdout 并返回它给出的退出码
+inline int serve_forward(const std::vector<std::string>& args, bool& connected)
+{
+  connected = false;
+  sockaddr_un addr;
+  if (!serve_address(SERVE_SOCKET, addr)) return 1;
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return 1;
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+  {
+    ::close(fd);
+    return 1;
+  }
+  connected = true;
+
+  std::error_code ec;
+  std::string request = std::filesystem::current_path(ec).string();
+  request += '\0';
+  for (const auto& arg : args)
+  {
+    request += arg;
+    request += '\0';
+  }
+  request += '\0';
+  if (!serve_write_all(fd, request.data(), request.size()))
+  {
+    ::close(fd);
+    std::cerr << "[mkcc] Lost connection to mkcc serve\n";
+    return 1;
+  }
+
+  std::string status;
+  bool trailer = false;
+  char buffer[4096];
+  while (true)
+  {
+    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    for (ssize_t i = 0; i < n; ++i)
+    {
+      if (trailer)
+        status += buffer[i];
+      else if (buffer[i] == '\0')
+        trailer = true;
+      else
+        std::cout.put(buffer[i]);
+    }
+    std::cout.flush();
+  }
+  ::close(fd);
+  if (!trailer)
+  {
+    std::cerr << "[mkcc] Lost connection to mkcc serve\n";
+    return 1;
+  }
+  return std::atoi(status.c_str());
+}
+
+namespace serve_detail
+{
+inline char socket_path[PATH_MAX];  // 信号处理函数中删除套接字文件
+
+inline void on_signal(int)
+{
+  ::unlink(socket_path);
+  ::_exit(0);
+}
+}  // namespace serve_detail
+
+// 在当前目录监听 SERVE_SOCKET，逐个处理请求直到收到 "stop"。
+// handle 收到命令及其参数（不含工作目录），返回退出码
+inline int run_server(const std::function<int(const std::vector<std::string>&)>& handle)
+{
+  namespace fs = std::filesystem;
+  sockaddr_un addr;
+  std::error_code ec;
+  fs::create_directories(".mkcc", ec);
+  if (!serve_address(SERVE_SOCKET, addr)) return 1;
+
+  // 已有守护进程在监听时不抢占；没有人监听的套接字文件是上次异常退出留下的
+  bool running = false;
+  serve_forward({"ping"}, running);
+  if (running)
+  {
+    std::cerr << "[mkcc] mkcc serve is already running in this project\n";
+    return 1;
+  }
+  ::unlink(SERVE_SOCKET);
+
+  int server = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (server < 0 ||
+      ::bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(server, 16) != 0)
+  {
+    std::cerr << "[mkcc] Cannot listen on " << SERVE_SOCKET << ": "
+              << std::strerror(errno) << "\n";
+    if (server >= 0) ::close(server);
+    return 1;
+  }
+
+  fs::path home = fs::current_path(ec);
+  std::string absolute = (home / SERVE_SOCKET).string();
+  std::strncpy(serve_detail::socket_path, absolute.c_str(),
+               sizeof(serve_detail::socket_path) - 1);
+  ::signal(SIGINT, serve_detail::on_signal);
+  ::signal(SIGTERM, serve_detail::on_signal);
+  ::signal(SIGPIPE, SIG_IGN);  // 客户端中途退出时 write 返回错误即可
+  file_caches_enabled = true;
+  std::cout << "[mkcc] Serving on " << absolute << std::endl;
+
+  bool stop = false;
+  while (!stop)
+  {
+    int client = ::accept4(server, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0)
+    {
+      if (errno == EINTR) continue;
+      break;
+    }
+    std::vector<std::string> fields;
+    if (!serve_read_request(client, fields) || fields.size() < 2)
+    {
+      ::close(client);
+      continue;
+    }
+    std::vector<std::string> args(fields.begin() + 1, fields.end());
+
+    // 请求期间 stdout/stderr 指向连接，编译器子进程的输出也直接回到客户端
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    int saved_out = ::dup(STDOUT_FILENO), saved_err = ::dup(STDERR_FILENO);
+    ::dup2(client, STDOUT_FILENO);
+    ::dup2(client, STDERR_FILENO);
+    int code = 0;
+    if (args[0] == "stop")
+    {
+      std::cout << "[mkcc] mkcc serve stopped\n";
+      stop = true;
+    }
+    else if (args[0] != "ping")
+    {
+      fs::current_path(fields[0], ec);
+      if (ec)
+      {
+        std::cerr << "[mkcc] Cannot enter " << fields[0] << "\n";
+        code = 1;
+      }
+      else
+      {
+        // 一个请求出错不能让守护进程退出
+        try
+        {
+          code = handle(args);
+        }
+        catch (const std::exception& e)
+        {
+          std::cerr << "[mkcc] " << args[0] << " failed: " << e.what() << "\n";
+          code = 1;
+        }
+      }
+      fs::current_path(home, ec);
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    ::dup2(saved_out, STDOUT_FILENO);
+    ::dup2(saved_err, STDERR_FILENO);
+    ::close(saved_out);
+    ::close(saved_err);
+    std::cout.clear();
+    std::cerr.clear();
+
+    std::string status(1, '\0');
+    status += std::to_string(code);
+    serve_write_all(client, status.data(), status.size());
+    ::close(client);
+
+    // 回复之后清理：文件被删除或改名后不再保留它们的缓存
+    prune_file_caches();
+  }
+  ::close(server);
+  ::unlink(SERVE_SOCKET);
+  return 0;
+}
+#endif
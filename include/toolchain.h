@@ -0,0 +1,207 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "build_cache.h"
+#include "trace.h"
+
+// 调用 C++ 编译器相关的工具函数：预编译头、运行时库与并行编译
+
+inline std::string quote(const std::string& s)
+{
+  return "\"" + s + "\"";
+}
+
+// 目标不存在，或比任一依赖旧时需要重新构建
+inline bool needs_rebuild(const std::filesystem::path& target,
+                          const std::vector<std::filesystem::path>& deps)
+{
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  auto target_time = fs::last_write_time(target, ec);
+  if (ec) return true;
+  for (const auto& dep : deps)
+  {
+    auto dep_time = fs::last_write_time(dep, ec);
+    if (ec || dep_time > target_time) return true;
+  }
+  return false;
+}
+
+// 在最多 jobs 个线程上对 [0, count) 执行 fn，jobs 为 0 时取 CPU 核数
+inline void parallel_for(size_t count, size_t jobs,
+                         const std::function<void(size_t)>& fn)
+{
+  if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+  jobs = std::min(jobs, count);
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]()
+  {
+    for (size_t i = next++; i < count; i = next++) fn(i);
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < jobs; ++i) workers.emplace_back(worker);
+  if (count > 0) worker();
+  for (auto& t : workers) t.join();
+}
+
+// 最多 jobs 个命令同时运行；返回第一个失败的退出码，全部成功返回 0。
+// 有命令失败后不再启动新的命令。labels 为各命令在构建 trace 中的名字
+inline int run_commands_parallel(const std::vector<std::string>& commands,
+                                 size_t jobs,
+                                 const std::vector<std::string>& labels = {},
+                                 const char* category = "compile")
+{
+  std::atomic<int> failure{0};
+  parallel_for(commands.size(), jobs, [&](size_t i)
+  {
+    if (failure != 0) return;
+    trace_span span(i < labels.size() ? labels[i] : "command", category,
+                    commands[i]);
+    int result = std::system(commands[i].c_str());
+    if (result != 0)
+    {
+      int expected = 0;
+      failure.compare_exchange_strong(expected, result);
+    }
+  });
+  return failure;
+}
+
+// 预编译运行时头文件（div.h + font.h + script.h + SFML），按编译器/参数/运行时内容
+// 缓存在 .mkcc/pch 下。失败时返回空串，调用方退回普通编译
+inline std::string ensure_runtime_pch(const std::string& compiler,
+                                      const std::string& flags,
+                                      const std::string& include_dir,
+                                      const std::string& runtime_hash)
+{
+  namespace fs = std::filesystem;
+  fs::path include_abs = fs::absolute(include_dir);
+  std::string key = hash_string(compiler + "\n" + flags + "\n" +
+                                include_abs.string() + "\n" + runtime_hash);
+  fs::path dir = fs::path(".mkcc") / "pch" / key;
+  fs::path header = dir / "mkcc_pch.h";
+  // clang 使用 .pch，gcc 使用 .gch，两者都会在 -include 时自动查找
+  fs::path pch = dir / (compiler.find("clang") != std::string::npos
+                            ? "mkcc_pch.h.pch"
+                            : "mkcc_pch.h.gch");
+  if (fs::exists(pch)) return header.string();
+
+  fs::create_directories(dir);
+  // 使用与生成代码相同的绝对路径包含，#pragma once 才能去重
+  std::string content;
+  for (const char* name : {"div.h", "font.h", "script.h", "ui_build.h"})
+  {
+    content += "#include " + quote((include_abs / name).generic_string()) + "\n";
+  }
+  write_file_if_changed(header.string(), content);
+
+  std::cout << "[mkcc] Precompiling runtime header...\n";
+  std::string cmd = compiler + " " + flags + " -x c++-header " +
+                    quote(header.string()) + " -o " + quote(pch.string());
+  int result = std::system(cmd.c_str());
+  if (result != 0)
+  {
+    std::cerr << "[mkcc] Failed to precompile runtime header, continuing "
+                 "without it\n";
+    fs::remove(pch);
+    return "";
+  }
+  return header.string();
+}
+
+// 返回运行时静态库路径。prebuilt 非空且存在时直接使用（调用方已确认它与
+// 本次的编译器和 -O 级别一致，见 prebuilt_runtime_matches）；否则用当前编译器
+// 与参数从 src 构建一次，缓存到 .mkcc/runtime 下。失败返回空串
+inline std::string ensure_runtime_library(const std::string& prebuilt,
+                                          const std::string& source_dir,
+                                          const std::string& include_dir,
+                                          const std::string& compiler,
+                                          const std::string& flags,
+                                          const std::string& runtime_hash,
+                                          size_t jobs)
+{
+  namespace fs = std::filesystem;
+  if (fs::exists(prebuilt)) return prebuilt;
+
+  std::string key =
+      hash_string(compiler + "\n" + flags + "\n" + runtime_hash);
+  fs::path dir = fs::path(".mkcc") / "runtime" / key;
+  fs::path library = dir / "libmkccrt.a";
+  if (fs::exists(library)) return library.string();
+
+  std::error_code ec;
+  if (!fs::is_directory(source_dir, ec))
+  {
+    std::cerr << "[mkcc] Runtime sources not found: " << source_dir << "\n";
+    return "";
+  }
+
+  std::cout << "[mkcc] Building runtime library...\n";
+  fs::create_directories(dir);
+  std::vector<std::string> commands, labels;
+  std::string objects;
+  for (const auto& entry : fs::directory_iterator(source_dir))
+  {
+    if (entry.path().extension() != ".cpp") continue;
+    fs::path object = dir / entry.path().filename().replace_extension(".o");
+    labels.push_back(entry.path().filename().string());
+    commands.push_back(compiler + " " + flags + " -I" + quote(include_dir) +
+                       " -c " + quote(entry.path().string()) + " -o " +
+                       quote(object.string()));
+    objects += " " + quote(object.string());
+  }
+
+  if (run_commands_parallel(commands, jobs, labels) != 0 ||
+      std::system(("ar rcs " + quote(library.string()) + objects).c_str()) !=
+          0)
+  {
+    std::cerr << "[mkcc] Failed to build runtime library\n";
+    fs::remove(library);
+    return "";
+  }
+  return library.string();
+}
+
+// 返回通用播放器路径。优先使用安装时预编译的 mkcc_player；没有时用 main.cpp
+// 加 -DMKCC_PLAYER 构建一次，缓存到 .mkcc/player 下。失败返回空串
+inline std::string ensure_player(const std::string& prebuilt,
+                                 const std::string& main_source,
+                                 const std::string& runtime_library,
+                                 const std::string& compiler,
+                                 const std::string& flags,
+                                 const std::string& runtime_hash)
+{
+  namespace fs = std::filesystem;
+  if (fs::exists(prebuilt)) return prebuilt;
+
+  std::string key =
+      hash_string(compiler + "\n" + flags + "\n" + runtime_hash);
+  fs::path dir = fs::path(".mkcc") / "player" / key;
+  fs::path player = dir / "mkcc_player";
+  if (fs::exists(player)) return player.string();
+
+  std::cout << "[mkcc] Building player...\n";
+  fs::create_directories(dir);
+  std::string cmd = compiler + " " + flags + " -DMKCC_PLAYER " +
+                    quote(main_source) + " " + quote(runtime_library) +
+                    " -o " + quote(player.string()) +
+                    " -lsfml-graphics -lsfml-window -lsfml-system";
+  if (std::system(cmd.c_str()) != 0)
+  {
+    std::cerr << "[mkcc] Failed to build player\n";
+    fs::remove(player);
+    return "";
+  }
+  return player.string();
+}
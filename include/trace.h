@@ -0,0 +1,200 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 构建耗时统计：mkcc make --timings 打印各阶段耗时，--trace=build.json 写出
+// Chrome/Perfetto 可读的 trace（chrome://tracing 或 ui.perfetto.dev 打开）。
+// 未启用时 trace_span 只检查一个标志，不读时钟也不加锁
+
+struct trace_event
+{
+  std::string name;
+  std::string category;  // phase：构建阶段；read：文件读取；compile/link：编译命令
+  std::string detail;    // 写入 trace 的 args，例如命令行
+  int64_t start_us;
+  int64_t duration_us;
+  int thread;
+};
+
+class build_trace
+{
+public:
+  static build_trace& instance()
+  {
+    static build_trace trace;
+    return trace;
+  }
+
+  // 开始一次命令的统计。mkcc serve 每个请求调用一次，之前的记录清空
+  void enable(bool print_timings, const std::string& trace_path)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    timings = print_timings;
+    path = trace_path;
+    enabled = timings || !path.empty();
+    origin = std::chrono::steady_clock::now();
+    threads.clear();
+    events.clear();
+  }
+
+  bool active() const { return enabled; }
+
+  int64_t now_us() const
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - origin)
+        .count();
+  }
+
+  void record(trace_event event)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto id = std::this_thread::get_id();
+    auto it = threads.find(id);
+    if (it == threads.end())
+      it = threads.emplace(id, static_cast<int>(threads.size()) + 1).first;
+    event.thread = it->second;
+    events.push_back(std::move(event));
+  }
+
+  // 打印统计并写出 trace 文件。在命令结束时调用一次
+  void finish()
+  {
+    if (!enabled) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (timings) print_timings();
+    if (!path.empty()) write_trace();
+  }
+
+private:
+  build_trace() : origin(std::chrono::steady_clock::now()) {}
+
+  // 并行执行的阶段会产生多个 span：wall 为首个开始到最后一个结束，
+  // sum 为各 span 耗时之和
+  void print_timings() const
+  {
+    struct phase_total
+    {
+      int64_t first = INT64_MAX, last = 0, sum = 0;
+      size_t count = 0;
+    };
+    std::vector<std::string> order;
+    std::map<std::string, phase_total> phases;
+    std::vector<const trace_event*> units;
+    int64_t end = 0;
+    for (const auto& e : events)
+    {
+      end = std::max(end, e.start_us + e.duration_us);
+      if (e.category == "compile") units.push_back(&e);
+      if (e.category != "phase") continue;
+      if (!phases.count(e.name)) order.push_back(e.name);
+      auto& p = phases[e.name];
+      p.first = std::min(p.first, e.start_us);
+      p.last = std::max(p.last, e.start_us + e.duration_us);
+      p.sum += e.duration_us;
+      ++p.count;
+    }
+
+    auto ms = [](int64_t us) { return us / 1000.0; };
+    std::cout << std::fixed << std::setprecision(1)
+              << "[mkcc] Build timings (wall ms):\n";
+    for (const auto& name : order)
+    {
+      const auto& p = phases.at(name);
+      std::cout << "  " << std::left << std::setw(18) << name << std::right
+                << std::setw(10) << ms(p.last - p.first);
+      if (p.count > 1)
+        std::cout << "  (" << p.count << " spans, sum " << ms(p.sum) << ")";
+      std::cout << "\n";
+    }
+    std::cout << "  " << std::left << std::setw(18) << "total" << std::right
+              << std::setw(10) << ms(end) << "\n";
+
+    // 最慢的几个翻译单元，通常就是优化的方向
+    std::sort(units.begin(), units.end(), [](auto* a, auto* b)
+              { return a->duration_us > b->duration_us; });
+    if (units.size() > 5) units.resize(5);
+    for (const auto* e : units)
+    {
+      std::cout << "  compile " << e->name << ": " << ms(e->duration_us)
+                << "\n";
+    }
+    std::cout << std::defaultfloat;
+  }
+
+  void write_trace() const
+  {
+    nlohmann::json list = nlohmann::json::array();
+    for (const auto& e : events)
+    {
+      nlohmann::json j = {{"name", e.name}, {"cat", e.category},
+                          {"ph", "X"},      {"ts", e.start_us},
+                          {"dur", e.duration_us}, {"pid", 1},
+                          {"tid", e.thread}};
+      if (!e.detail.empty()) j["args"] = {{"detail", e.detail}};
+      list.push_back(std::move(j));
+    }
+    std::ofstream file(path);
+    if (!file)
+    {
+      std::cerr << "[mkcc] Failed to write trace: " << path << "\n";
+      return;
+    }
+    file << nlohmann::json{{"traceEvents", list}, {"displayTimeUnit", "ms"}}
+                .dump()
+         << "\n";
+    std::cout << "[mkcc] Trace written to " << path << "\n";
+  }
+
+  std::chrono::steady_clock::time_point origin;
+  bool enabled = false;
+  bool timings = false;
+  std::string path;
+  std::mutex mutex;
+  std::map<std::thread::id, int> threads;
+  std::vector<trace_event> events;
+};
+
+// 作用域内的耗时记为一个 span
+class trace_span
+{
+public:
+  trace_span(std::string name, const char* category = "phase",
+             std::string detail = "")
+  {
+    build_trace& trace = build_trace::instance();
+    if (!trace.active()) return;
+    active = true;
+    event.name = std::move(name);
+    event.category = category;
+    event.detail = std::move(detail);
+    event.start_us = trace.now_us();
+  }
+  ~trace_span() { end(); }
+  trace_span(const trace_span&) = delete;
+  trace_span& operator=(const trace_span&) = delete;
+
+  // 提前结束 span，之后的析构不再记录
+  void end()
+  {
+    if (!active) return;
+    active = false;
+    build_trace& trace = build_trace::instance();
+    event.duration_us = trace.now_us() - event.start_us;
+    trace.record(std::move(event));
+  }
+
+private:
+  bool active = false;
+  trace_event event;
+};
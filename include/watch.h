@@ -0,0 +1,161 @@
+#pragma once
+// mkcc watch 使用的平台相关工具：inotify 文件监视、子进程管理与重载通知。
+// 仅支持 Linux
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+extern char** environ;
+
+// 监视文件所在的目录而不是文件本身：编辑器常用"写临时文件再改名"的方式保存，
+// 直接监视文件会在第一次保存后失效
+class file_watcher
+{
+public:
+  file_watcher() : fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {}
+  ~file_watcher()
+  {
+    if (fd >= 0) close(fd);
+  }
+  file_watcher(const file_watcher&) = delete;
+  file_watcher& operator=(const file_watcher&) = delete;
+
+  bool valid() const { return fd >= 0; }
+
+  // 替换监视的文件集合
+  void set_files(const std::vector<std::string>& paths)
+  {
+    namespace fs = std::filesystem;
+    files.clear();
+    for (const auto& path : paths)
+    {
+      fs::path abs = fs::absolute(path).lexically_normal();
+      files.insert(abs.string());
+      std::string dir = abs.parent_path().string();
+      if (watched_dirs.count(dir)) continue;
+
+      int wd = inotify_add_watch(fd, dir.c_str(),
+                                 IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+      if (wd >= 0)
+      {
+        watched_dirs.insert(dir);
+        dirs[wd] = dir;
+      }
+    }
+  }
+
+  // 等待被监视的文件发生变化，返回变化的文件（已去重）。
+  // 收到第一个事件后再等 debounce_ms 合并同一次保存产生的多个事件；超时返回空
+  std::set<std::string> wait(int timeout_ms, int debounce_ms = 50)
+  {
+    std::set<std::string> changed;
+    pollfd pfd{fd, POLLIN, 0};
+    if (::poll(&pfd, 1, timeout_ms) <= 0) return changed;
+
+    do
+    {
+      drain(changed);
+    } while (::poll(&pfd, 1, debounce_ms) > 0);
+    return changed;
+  }
+
+private:
+  void drain(std::set<std::string>& changed)
+  {
+    alignas(inotify_event) char buffer[4096];
+    ssize_t len;
+    while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+      for (char* p = buffer; p < buffer + len;)
+      {
+        auto* event = reinterpret_cast<inotify_event*>(p);
+        p += sizeof(inotify_event) + event->len;
+        auto dir = dirs.find(event->wd);
+        if (dir == dirs.end() || event->len == 0) continue;
+
+        std::string path = dir->second + "/" + event->name;
+        if (files.count(path)) changed.insert(path);
+      }
+    }
+  }
+
+  int fd;
+  std::map<int, std::string> dirs;
+  std::set<std::string> watched_dirs;
+  std::set<std::string> files;
+};
+
+// 启动子进程，extra_env 追加到当前环境变量之后。失败返回 -1
+inline pid_t spawn_process(const std::vector<std::string>& args,
+                           const std::vector<std::string>& extra_env)
+{
+  std::vector<std::string> env_storage;
+  for (char** e = environ; *e; ++e) env_storage.emplace_back(*e);
+  env_storage.insert(env_storage.end(), extra_env.begin(), extra_env.end());
+
+  std::vector<char*> argv, envp;
+  for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+  for (const auto& e : env_storage) envp.push_back(const_cast<char*>(e.c_str()));
+  argv.push_back(nullptr);
+  envp.push_back(nullptr);
+
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    execve(argv[0], argv.data(), envp.data());
+    _exit(127);
+  }
+  return pid;
+}
+
+// 子进程仍在运行时返回 true；已退出则回收它
+inline bool process_running(pid_t pid)
+{
+  if (pid <= 0) return false;
+  int status = 0;
+  return waitpid(pid, &status, WNOHANG) == 0;
+}
+
+inline void stop_process(pid_t pid)
+{
+  if (!process_running(pid)) return;
+  kill(pid, SIGTERM);
+  int status = 0;
+  waitpid(pid, &status, 0);
+}
+
+inline bool create_reload_pipe(const std::string& path)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0)
+  {
+    if (S_ISFIFO(st.st_mode)) return true;
+    unlink(path.c_str());
+  }
+  return mkfifo(path.c_str(), 0600) == 0;
+}
+
+// 通知正在运行的程序重新加载；没有读端（程序未运行）时返回 false
+inline bool notify_reload(const std::string& path)
+{
+  int fd = open(path.c_str(), O_WRONLY | O_NONBLOCK);
+  if (fd < 0) return false;
+  bool ok = write(fd, "r", 1) == 1;
+  close(fd);
+  return ok;
+}
+#endif
@@ -1,11 +1,20 @@
+#include <charconv>
 #include <cstdlib>  // for std::system
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <set>
 #include <string>
 
+#include "include/build_cache.h"
+#include "include/checker.h"
 #include "include/compiler.h"
+#include "include/profile.h"
+#include "include/serve.h"
+#include "include/toolchain.h"
+#include "include/trace.h"
+#include "include/watch.h"
 using json = nlohmann::json;
 namespace fs = std::filesystem;
 
@@ -14,6 +23,7 @@ namespace fs = std::filesystem;
 #else
 #define PSEP "/"
 #endif
+#define MKCC_VERSION "1.0.0"
 inline std::string PATH(const std::string& x, const std::string& y)
 {
   return (fs::path(x) / y).string();
@@ -65,8 +75,11 @@ void copy_file_safe(const std::string& from, const std::string& to)
     std::cerr << "[mkcc] Failed to copy " << from << ": " << e.what() << "\n";
   }
 }
-void copy_directory_safe(const fs::path& from, const fs::path& to)
+// 把 from 目录同步到 to：只写入内容不同的文件，删除 from 中已不存在的文件。
+// 未变化的文件保留原 mtime，不会让依赖它们的目标文件失效。返回写入与删除的文件数
+size_t sync_directory_safe(const fs::path& from, const fs::path& to)
 {
+  size_t changed = 0;
   try
   {
     if (!fs::exists(from) || !fs::is_directory(from))
@@ -74,7 +87,7 @@ void copy_directory_safe(const fs::path& from, const fs::path& to)
       std::cerr
           << "[mkcc] Source directory does not exist or is not a directory: "
           << from << "\n";
-      return;
+      return 0;
     }
 
     // 创建目标目录（如果不存在）
@@ -95,12 +108,11 @@ void copy_directory_safe(const fs::path& from, const fs::path& to)
         {
           fs::create_directories(target_path);
         }
-        else if (fs::is_regular_file(path))
+        else if (fs::is_regular_file(path) &&
+                 write_file_if_changed(target_path.string(),
+                                       mapped_file(path.string()).view()))
         {
-          fs::copy_file(path, target_path,
-                        fs::copy_options::overwrite_existing);
-          std::cout << "[mkcc] Copied: " << path << " → " << target_path
-                    << "\n";
+          ++changed;
         }
         // 忽略符号链接和其他类型
       }
@@ -110,11 +122,26 @@ void copy_directory_safe(const fs::path& from, const fs::path& to)
                   << "\n";
       }
     }
+
+    // 运行时删除的头文件也要从副本中删除，否则仍可能被包含
+    std::vector<fs::path> stale;
+    for (const auto& entry : fs::recursive_directory_iterator(to))
+    {
+      if (entry.is_regular_file() &&
+          !fs::exists(from / fs::relative(entry.path(), to)))
+        stale.push_back(entry.path());
+    }
+    for (const auto& path : stale)
+    {
+      fs::remove(path);
+      ++changed;
+    }
   }
   catch (const fs::filesystem_error& e)
   {
-    std::cerr << "[mkcc] Directory copy failed: " << e.what() << "\n";
+    std::cerr << "[mkcc] Directory sync failed: " << e.what() << "\n";
   }
+  return changed;
 }
 
 void show_help()
@@ -122,9 +149,14 @@ void show_help()
   std::cout << "mkcc - Markup + C++ project tool\n\n";
   std::cout << "Usage:\n";
   std::cout << "mkcc init Initializes the project template\n";
-  std::cout << "mkcc make Compiles the project\n";
-  std::cout << "mkcc run Runs the project\n";
-  std::cout << "mkcc release Packages the release version\n";
+  std::cout << "mkcc make [-jN] [--profile=NAME] [--timings] [--trace=FILE] "
+               "Compiles the project\n";
+  std::cout << "mkcc run [--profile=NAME] [--interpret] Runs the project\n";
+  std::cout << "mkcc check [-jN] [FILE|DIR...] Validates MKML without compiling\n";
+  std::cout << "mkcc watch Rebuilds and live-reloads on file changes\n";
+  std::cout << "mkcc serve [stop] Keeps a build daemon for make/check in "
+               "this project\n";
+  std::cout << "mkcc release [--pgo] Packages the release version\n";
   std::cout << "mkcc help Displays help information\n";
 }
 void init()
@@ -155,77 +187,762 @@ void init()
   }
   
 }
-int make(){
+bool load_config(json& config)
+{
   std::ifstream json_file("mkccmake.json");
-    if (!json_file)
+  if (!json_file)
+  {
+    std::cerr << "[mkcc] Error: mkccmake.json not found.\n";
+    return false;
+  }
+
+  try
+  {
+    json_file >> config;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << "[mkcc] JSON parsing error: " << e.what() << "\n";
+    return false;
+  }
+  return true;
+}
+
+struct build_options
+{
+  size_t jobs = 0;
+  std::string profile;  // 为空时使用 mkccmake.json 的 "profile"，默认 debug
+  pgo_stage pgo = pgo_stage::none;
+  bool timings = false;    // --timings：打印各阶段耗时
+  std::string trace_path;  // --trace=FILE：写出 Chrome trace
+  bool valid = true;       // 参数有误时为 false，错误已经打印
+};
+
+build_profile resolve_profile(const json& config, const build_options& options)
+{
+  std::string name = options.profile.empty()
+                         ? config.value("profile", std::string("debug"))
+                         : options.profile;
+  build_profile profile = load_build_profile(config, name);
+  profile.pgo = options.pgo;
+  profile.pgo_dir = fs::absolute(PATH(PATH(".mkcc", "pgo"), name)).string();
+  return profile;
+}
+
+// 项目的入口文件：优先使用 "entries" 列表，否则使用单个 "entry"
+std::vector<std::string> project_entries(const json& config)
+{
+  if (config.contains("entries") && config["entries"].is_array())
+  {
+    return config["entries"].get<std::vector<std::string>>();
+  }
+  return {config.value("entry", "")};
+}
+
+// 单入口项目直接输出到 output 目录；多入口项目每个入口一个子目录
+std::string entry_output_dir(const json& config, const std::string& entry)
+{
+  std::string build = conversion_path(config.value("output", "build"));
+  if (!config.contains("entries")) return build;
+  return PATH(build, fs::path(entry).stem().string());
+}
+
+// debug 配置档沿用原来的 build.out，其他配置档各自输出。entry 为空时取第一个入口
+std::string output_binary_path(const json& config, const build_profile& profile,
+                               const std::string& entry = "")
+{
+  std::string dir =
+      entry_output_dir(config, entry.empty() ? project_entries(config)[0] : entry);
+  std::string variant = profile.variant();
+  if (profile.pgo == pgo_stage::generate) variant += "-instrumented";
+  return PATH(dir, variant == "debug" ? "build.out"
+                                      : "build-" + variant + ".out");
+}
+
+// 一个入口文件的构建状态
+struct entry_build
+{
+  std::string entry;
+  std::string dir;  // 生成的翻译单元所在目录
+  std::string binary;
+  std::string cache_path;
+  build_cache cache;
+  // 入口文件与它引用的文件 → 读取之前的哈希。构建期间文件被修改时，
+  // 缓存记录的是旧内容，下次构建会发现不一致
+  std::map<std::string, std::string> inputs;
+  std::vector<std::string> commands;  // 需要重新编译的翻译单元
+  std::vector<std::string> labels;
+  std::string objects;
+  bool up_to_date = false;
+  bool failed = false;
+};
+
+int make(const build_options& options = {}){
+    trace_span config_span("config");
+    json config;
+    if (!load_config(config)) return 1;
+
+    std::string name = config.value("name", "unknown");
+    std::string version = config.value("version", "0.0.0");
+    std::string build = conversion_path(config.value("output", "build"));
+    build_profile profile = resolve_profile(config, options);
+    if (profile.name != "debug" && profile.name != "release" &&
+        !(config.contains("profiles") && config["profiles"].contains(profile.name)))
     {
-      std::cerr << "[mkcc] Error: mkccmake.json not found.\n";
+      std::cerr << "[mkcc] Unknown build profile: " << profile.name << "\n";
       return 1;
     }
 
-    json config;
-    try
+    std::cout << "[mkcc] Building the '" << name << "' version " << version
+              << " (" << profile.variant() << ")...\n";
+
+    std::string template_path = ppath(PATH("mkcc_resource", "main.cpp"));
+    std::string runtime_include = ppath(PATH("mkcc_resource", "include"));
+    std::string runtime_src = ppath(PATH("mkcc_resource", "src"));
+    std::string runtime_prebuilt =
+        ppath(PATH(PATH("mkcc_resource", "lib"), "libmkccrt.a"));
+    std::string runtime_prebuilt_key =
+        read_file(ppath(PATH(PATH("mkcc_resource", "lib"), "libmkccrt.key")));
+
+    config_span.end();
+
+    trace_span hash_span("hash runtime");
+    std::string config_hash = hash_string(std::string(MKCC_VERSION) + config.dump());
+    std::string runtime_hash =
+        hash_string(hash_file(template_path) + hash_directory(runtime_include) +
+                    hash_directory(runtime_src) + hash_file(runtime_prebuilt) +
+                    runtime_prebuilt_key);
+    std::string compiler = profile.compiler;
+    std::string flags = profile.compile_flags();
+    // PGO 使用阶段的输入还包括训练得到的 profile 数据
+    std::string flags_hash = hash_string(
+        compiler + "\n" + flags + "\n" + profile.link_flags() +
+        (profile.pgo == pgo_stage::use ? hash_directory(profile.pgo_dir) : ""));
+    size_t jobs = options.jobs;
+    if (jobs == 0) jobs = config.value("jobs", 0);
+    hash_span.end();
+
+    // 每个入口、每个配置档的目标文件与缓存相互独立
+    bool multi_entry = config.contains("entries");
+    std::vector<entry_build> builds;
+    std::set<std::string> dirs;
+    for (const auto& entry : project_entries(config))
+    {
+      entry_build b;
+      b.entry = entry;
+      b.dir = entry_output_dir(config, entry);
+      b.binary = output_binary_path(config, profile, entry);
+      b.cache_path = PATH(".mkcc", "build_cache_" + profile.variant() +
+                                       (multi_entry ? "_" + fs::path(entry).stem().string() : "") +
+                                       ".json");
+      if (!dirs.insert(b.dir).second)
+      {
+        std::cerr << "[mkcc] Entries must have distinct file names: " << entry
+                  << "\n";
+        return 1;
+      }
+      builds.push_back(std::move(b));
+    }
+
+    // 所有输入的哈希与上次构建一致时，直接跳过代码生成与编译
+    parallel_for(builds.size(), jobs, [&](size_t i)
+    {
+      trace_span span("cache check");
+      entry_build& b = builds[i];
+      b.cache = load_build_cache(b.cache_path);
+      b.up_to_date = b.cache.runtime == runtime_hash &&
+                     b.cache.config == config_hash &&
+                     b.cache.flags == flags_hash && b.cache.inputs.count(b.entry) &&
+                     b.cache.inputs_unchanged() && fs::exists(b.binary);
+    });
+    bool rebuild_runtime = false;
+    bool all_up_to_date = true;
+    for (const auto& b : builds)
     {
-      json_file >> config;
+      if (!b.up_to_date)
+      {
+        all_up_to_date = false;
+        rebuild_runtime |= b.cache.runtime != runtime_hash || b.cache.flags != flags_hash;
+      }
     }
-    catch (const std::exception& e)
+    if (all_up_to_date)
     {
-      std::cerr << "[mkcc] JSON parsing error: " << e.what() << "\n";
-      return 1;
+      for (const auto& b : builds)
+        std::cout << "[mkcc] Up to date: " << b.binary << "\n";
+      return 0;
     }
 
-    std::string name = config.value("name", "unknown");
-    std::string version = config.value("version", "0.0.0");
-    std::string entry = config.value("entry", "");
-    std::string build = conversion_path(config.value("output", "build"));
+    // 创建构建输出目录，运行时头文件与预编译头由所有入口共用
+    if (!std::filesystem::exists(build))
+    {
+      std::filesystem::create_directories(build);
+    }
+    // 运行时头文件默认同步到 build/include，只写入有变化的文件；
+    // "runtime_include": "installed" 时直接使用安装目录，不复制
+    std::string include_dir = PATH(build, "include");
+    std::string include_root = build;
+    if (config.value("runtime_include", std::string("copy")) == "installed")
+    {
+      // 旧的副本会先于安装目录被找到，必须删除
+      std::error_code ec;
+      fs::remove_all(include_dir, ec);
+      include_dir = runtime_include;
+      include_root = ppath("mkcc_resource");
+    }
+    else
+    {
+      trace_span span("sync runtime");
+      size_t synced = sync_directory_safe(runtime_include, include_dir);
+      if (synced > 0)
+      {
+        std::cout << "[mkcc] Synced " << synced << " runtime file(s) to "
+                  << include_dir << "\n";
+      }
+    }
 
-    std::cout << "[mkcc] Building the '" << name << "' version " << version
-              << "...\n";
+    std::string pch_header;
+    if (config.value("pch", true))
+    {
+      trace_span span("pch");
+      pch_header = ensure_runtime_pch(compiler, flags, include_dir,
+                                      runtime_hash);
+    }
+    // 生成的源码用 #include "include/div.h"，通过 -I 找到共用的 include
+    std::string unit_flags = " -I" + quote(include_root);
+    if (!pch_header.empty())
+      unit_flags += " -Winvalid-pch -include " + quote(pch_header);
 
-    std::ifstream file(entry);
-    if (!file.is_open())
+    // 需要重新编译时返回编译命令，否则返回空串
+    auto compile_command = [&](const fs::path& source, const fs::path& object,
+                               const std::string& extra, bool rebuild_all)
     {
-      std::cerr << "[mkcc] Unable to open entry file: " << entry << std::endl;
-      return 1;
+      if (!rebuild_all && !needs_rebuild(object, {source})) return std::string();
+
+      // 先删除旧目标文件，编译失败时下次构建一定会重试
+      fs::remove(object);
+      return compiler + " " + flags + extra + " -c " + quote(source.string()) +
+             " -o " + quote(object.string());
+    };
+
+    // LTO/PGO/静态 SFML 需要运行时用同样的参数编译，直接并入本项目的翻译单元
+    fs::path shared_obj_dir = fs::path(build) / "obj" / profile.variant();
+    std::vector<std::string> commands;
+    std::vector<std::string> labels;  // 翻译单元在 trace 中的名字
+    std::string runtime_objects;
+    std::string runtime_library;
+    if (profile.can_link_runtime_library())
+    {
+      // 预编译的运行时来自另一种编译器时，按本次参数另外编译一份
+      trace_span span("runtime library");
+      runtime_library = ensure_runtime_library(
+          profile.can_use_prebuilt_runtime(runtime_prebuilt_key)
+              ? runtime_prebuilt
+              : "",
+          runtime_src, runtime_include, compiler, flags, runtime_hash, jobs);
+      if (runtime_library.empty()) return 1;
+      runtime_objects = " " + quote(runtime_library);
+    }
+    else
+    {
+      fs::create_directories(shared_obj_dir);
+      for (const auto& entry : fs::directory_iterator(runtime_src))
+      {
+        if (entry.path().extension() != ".cpp") continue;
+        fs::path object =
+            shared_obj_dir / ("mkccrt_" + entry.path().stem().string() + ".o");
+        runtime_objects += " " + quote(object.string());
+        std::string cmd =
+            compile_command(entry.path(), object,
+                            " -I" + quote(runtime_include), rebuild_runtime);
+        if (cmd.empty()) continue;
+        commands.push_back(cmd);
+        labels.push_back(entry.path().filename().string());
+      }
     }
 
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    std::string markup_source = ss.str();
-    file.close();
+    // 各入口的解析与代码生成在线程池上并行执行
+    const main_template& main_cpp = load_main_template(template_path);
+    parallel_for(builds.size(), jobs, [&](size_t i)
+    {
+      entry_build& b = builds[i];
+      if (b.up_to_date) return;
+
+      trace_span parse_span("parse");
+      b.inputs[b.entry] = hash_file(b.entry);
+      // mkcc serve 中未变化的文件直接复用上次的解析结果
+      std::shared_ptr<const mkml_document> doc = load_mkml_file(b.entry);
+      if (!doc)
+      {
+        std::cerr << "[mkcc] Unable to open entry file: " + b.entry + "\n";
+        b.failed = true;
+        return;
+      }
+      const mkml_node& root = *doc->root;
+      // <style src>/<script src> 在代码生成时才读取，先记下哈希
+      for (const auto& source : collect_sources(root))
+        b.inputs.emplace(source, hash_file(source));
+      parse_span.end();
 
-    mkml_node root = parse_html_to_mkml(markup_source);
+      trace_span codegen_span("codegen");
+      std::vector<generated_unit> units = generate_units(root, main_cpp);
+      codegen_span.end();
 
-    // 创建构建输出目录
-    if (!std::filesystem::exists(build))
+      // 写入各翻译单元，内容未变化时保留原文件（及其 mtime）
+      // 运行时或编译参数变化时，所有目标文件都要重新编译
+      bool rebuild_all = b.cache.runtime != runtime_hash || b.cache.flags != flags_hash;
+      fs::path obj_dir = fs::path(b.dir) / "obj" / profile.variant();
+      fs::create_directories(obj_dir);
+      trace_span write_span("write sources");
+      for (const auto& unit : units)
+      {
+        fs::path source = fs::path(b.dir) / unit.file;
+        if (write_file_if_changed(source.string(), unit.source))
+        {
+          std::cout << "[mkcc] File generated " + source.string() + "\n";
+        }
+        fs::path object = obj_dir / fs::path(unit.file).replace_extension(".o");
+        b.objects += " " + quote(object.string());
+        std::string cmd = compile_command(source, object, unit_flags, rebuild_all);
+        if (cmd.empty()) continue;
+        b.commands.push_back(cmd);
+        b.labels.push_back(source.string());
+      }
+    });
+
+    size_t entry_commands = 0;
+    for (auto& b : builds)
     {
-      std::filesystem::create_directories(build);
+      if (b.failed) return 1;
+      commands.insert(commands.end(), b.commands.begin(), b.commands.end());
+      labels.insert(labels.end(), b.labels.begin(), b.labels.end());
+      entry_commands += b.commands.size();
     }
 
-    // 写入 main.cpp
-    std::string output_cpp_path = PATH(build, "main.cpp");
-    copy_file_safe(ppath(PATH("mkcc_resource", "main.cpp")), output_cpp_path);
-    copy_directory_safe(ppath(PATH("mkcc_resource", "include")),
-                        PATH(build, "include"));
-    compile(root, output_cpp_path);
-    std::cout<<"[mkcc] Compiling...\n";
-    std::string output_binary = PATH(build, "build.out");  // 可执行文件名
+    // 所有入口的翻译单元一起并行编译，受 jobs 限制
+    if (!commands.empty())
+    {
+      std::cout << "[mkcc] Compiling " << commands.size()
+                << " translation units...\n";
+      trace_span span("compile");
+      int result = run_commands_parallel(commands, jobs, labels);
+      if (result != 0)
+      {
+        std::cerr << "[mkcc] Compilation failed with code: " << result << "\n";
+        return result;
+      }
+    }
 
-    std::ostringstream cmd;
-    cmd << "g++ " << output_cpp_path << " -std=c++17 -o " << output_binary
-        << " -lsfml-graphics -lsfml-window -lsfml-system";
+    std::vector<std::string> link_commands;
+    std::vector<std::string> link_labels;
+    bool runtime_rebuilt = commands.size() > entry_commands;
+    for (auto& b : builds)
+    {
+      if (b.up_to_date) continue;
+      bool relink = !b.commands.empty() || runtime_rebuilt ||
+                    !fs::exists(b.binary) ||
+                    (!runtime_library.empty() &&
+                     needs_rebuild(b.binary, {runtime_library}));
+      if (!relink) continue;
 
-    int result = std::system(cmd.str().c_str());
-    if (result != 0)
+      fs::remove(b.binary);
+      link_labels.push_back(b.binary);
+      link_commands.push_back(compiler + " " + flags + b.objects +
+                              runtime_objects + " -o " + quote(b.binary) +
+                              profile.link_flags());
+    }
+    if (!link_commands.empty())
     {
-      std::cerr << "[mkcc] Compilation failed with code: " << result << "\n";
-      return result;
+      std::cout << "[mkcc] Linking...\n";
+      trace_span span("link");
+      int result = run_commands_parallel(link_commands, jobs, link_labels, "link");
+      if (result != 0)
+      {
+        std::cerr << "[mkcc] Linking failed with code: " << result << "\n";
+        return result;
+      }
+    }
+    else
+    {
+      std::cout << "[mkcc] Generated source unchanged, skipping compilation\n";
     }
 
-    std::cout << "[mkcc] Build complete: " << output_binary << "\n";
+    // 仅在构建成功后更新缓存，失败的构建下次会重试
+    trace_span save_span("save cache");
+    fs::create_directories(".mkcc");
+    for (auto& b : builds)
+    {
+      if (b.up_to_date) continue;
+      b.cache.config = config_hash;
+      b.cache.runtime = runtime_hash;
+      b.cache.flags = flags_hash;
+      b.cache.inputs = b.inputs;
+      save_build_cache(b.cache_path, b.cache);
+      std::cout << "[mkcc] Build complete: " << b.binary << "\n";
+    }
     return 0;
 }
 
+// mkcc release --pgo：插桩构建 → 训练运行 → 使用 profile 数据重新构建
+int make_pgo(const json& config, build_options options)
+{
+  build_profile profile = resolve_profile(config, options);
+  std::error_code ec;
+  fs::remove_all(profile.pgo_dir, ec);
+  fs::create_directories(profile.pgo_dir);
+
+  options.pgo = pgo_stage::generate;
+  int code = make(options);
+  if (code != 0) return code;
+
+  // 每个入口各做一次训练运行，profile 数据累积在同一目录
+  profile.pgo = pgo_stage::generate;
+  for (const auto& entry : project_entries(config))
+  {
+    std::string training = output_binary_path(config, profile, entry);
+    if (config.contains("pgo"))
+    {
+      training += " " + config["pgo"].value("training_args", std::string());
+    }
+    std::cout << "[mkcc] PGO training run: " << training << "\n"
+              << "[mkcc] Exercise the application, then close its window.\n";
+    code = std::system(training.c_str());
+    if (code != 0)
+    {
+      std::cerr << "[mkcc] Training run exited with code " << code << "\n";
+      return code;
+    }
+  }
+
+  // clang 写出的是 .profraw，需要先合并成 .profdata
+  if (profile.is_clang())
+  {
+    std::string merge = "llvm-profdata merge -output=" +
+                        quote(PATH(profile.pgo_dir, "default.profdata")) +
+                        " " + quote(profile.pgo_dir) + "/*.profraw";
+    code = std::system(merge.c_str());
+    if (code != 0)
+    {
+      std::cerr << "[mkcc] llvm-profdata merge failed with code " << code
+                << "\n";
+      return code;
+    }
+  }
+
+  options.pgo = pgo_stage::use;
+  return make(options);
+}
+
+// 返回通用播放器路径，必要时先构建运行时库与播放器；失败返回空串
+std::string prepare_player()
+{
+  std::string player_prebuilt =
+      ppath(PATH(PATH("mkcc_resource", "bin"), "mkcc_player"));
+  if (fs::exists(player_prebuilt)) return player_prebuilt;
+
+  // 播放器使用固定的优化参数，与项目的配置档无关
+  std::string compiler = "g++";
+  std::string flags = "-std=c++17 -O2";
+  std::string runtime_include = ppath(PATH("mkcc_resource", "include"));
+  std::string runtime_src = ppath(PATH("mkcc_resource", "src"));
+  std::string template_path = ppath(PATH("mkcc_resource", "main.cpp"));
+  std::string runtime_hash =
+      hash_string(hash_file(template_path) + hash_directory(runtime_include) +
+                  hash_directory(runtime_src));
+  std::string prebuilt = ppath(PATH(PATH("mkcc_resource", "lib"), "libmkccrt.a"));
+  std::string prebuilt_key =
+      read_file(ppath(PATH(PATH("mkcc_resource", "lib"), "libmkccrt.key")));
+  std::string runtime_library = ensure_runtime_library(
+      prebuilt_runtime_matches(prebuilt_key, compiler) ? prebuilt : "",
+      runtime_src, runtime_include, compiler, flags, runtime_hash, 0);
+  if (runtime_library.empty()) return "";
+  return ensure_player(player_prebuilt, template_path, runtime_library,
+                       compiler, flags, runtime_hash);
+}
+
+// 先写临时文件再改名，正在运行的程序不会读到写了一半的描述
+void write_ui_description(const mkml_node& root, const std::string& path)
+{
+  std::string tmp = path + ".tmp";
+  write_file(tmp, serialize_ui_document(build_ui_document(root)));
+  std::error_code ec;
+  fs::rename(tmp, path, ec);
+  if (ec)
+  {
+    std::cerr << "[mkcc] Failed to write " << path << ": " << ec.message()
+              << "\n";
+  }
+}
+
+// mkcc run --interpret：把 MKML 转换为 .mkui 描述交给通用播放器，不调用 C++ 编译器。
+// 含 <script> 的页面必须编译，此时 fallback 置为 true
+int run_interpreted(const json& config, bool& fallback)
+{
+  fallback = false;
+  std::string entry = project_entries(config)[0];
+  mapped_file markup_source(entry);
+  if (markup_source.view().empty())
+  {
+    std::cerr << "[mkcc] Unable to open entry file: " << entry << std::endl;
+    return 1;
+  }
+
+  mkml_document doc = parse_html_to_mkml(markup_source.view());
+  const mkml_node& root = *doc.root;
+  if (uses_scripts(root))
+  {
+    std::cout << "[mkcc] <script> requires compiled mode, falling back to "
+                 "mkcc make\n";
+    fallback = true;
+    return 0;
+  }
+
+  fs::create_directories(".mkcc");
+  std::string ui_path = PATH(".mkcc", "app.mkui");
+  write_ui_description(root, ui_path);
+
+  std::string player = prepare_player();
+  if (player.empty()) return 1;
+
+  std::cout << "[mkcc] Running " << entry << " in player\n";
+  return std::system((quote(player) + " " + quote(ui_path)).c_str());
+}
+
+// mkcc watch：监视入口文件及其引用的样式/脚本。标记与样式的变化通过命名管道
+// 推送给正在运行的程序原地重建界面；只有脚本代码变化时才重新编译并重启
+int watch()
+{
+#ifndef __linux__
+  std::cerr << "[mkcc] mkcc watch requires Linux (inotify)\n";
+  return 1;
+#else
+  json config;
+  if (!load_config(config)) return 1;
+  std::string entry = project_entries(config)[0];
+  std::cout << std::unitbuf;  // 长时间运行，日志需要立即可见
+
+  file_watcher watcher;
+  if (!watcher.valid())
+  {
+    std::cerr << "[mkcc] Failed to initialize inotify\n";
+    return 1;
+  }
+
+  fs::create_directories(".mkcc");
+  std::string ui_path = fs::absolute(PATH(".mkcc", "app.mkui")).string();
+  std::string pipe_path = fs::absolute(PATH(".mkcc", "reload.pipe")).string();
+  if (!create_reload_pipe(pipe_path))
+  {
+    std::cerr << "[mkcc] Failed to create " << pipe_path << "\n";
+    return 1;
+  }
+  std::vector<std::string> env = {"MKCC_RELOAD_PIPE=" + pipe_path,
+                                  "MKCC_RELOAD_UI=" + ui_path};
+
+  pid_t app = -1;
+  std::vector<std::string> app_args;
+  bool needs_build = true;
+  std::string fingerprint;
+  while (true)
+  {
+    mkml_document doc = parse_html_to_mkml(read_file(entry));
+    const mkml_node& root = *doc.root;
+    std::vector<std::string> files = collect_sources(root);
+    files.insert(files.begin(), entry);
+    watcher.set_files(files);
+    write_ui_description(root, ui_path);
+
+    std::string next_fingerprint = scripts_fingerprint(root);
+    if (needs_build || next_fingerprint != fingerprint)
+    {
+      // 脚本是 C++ 代码，变化时只能完整重建并重启
+      stop_process(app);
+      app = -1;
+      app_args.clear();
+      fingerprint = next_fingerprint;
+      if (!uses_scripts(root))
+      {
+        std::string player = prepare_player();
+        if (!player.empty()) app_args = {player, ui_path};
+      }
+      else if (make() == 0)
+      {
+        build_options options;
+        app_args = {fs::absolute(output_binary_path(
+                                     config, resolve_profile(config, options)))
+                        .string()};
+      }
+      needs_build = app_args.empty();
+      if (!needs_build) app = spawn_process(app_args, env);
+    }
+    else if (!process_running(app))
+    {
+      // 程序已被关闭，有新的修改时重新启动
+      app = spawn_process(app_args, env);
+    }
+    else if (notify_reload(pipe_path))
+    {
+      std::cout << "[mkcc] Reloaded " << entry << "\n";
+    }
+
+    std::cout << "[mkcc] Watching " << files.size() << " file(s)...\n";
+    std::set<std::string> changed;
+    while (changed.empty())
+    {
+      changed = watcher.wait(500);
+      process_running(app);  // 回收已退出的子进程
+    }
+    for (const auto& path : changed)
+    {
+      std::cout << "[mkcc] Changed: " << path << "\n";
+    }
+  }
+#endif
+}
+
+// mkcc check：校验指定的 MKML 文件（目录递归查找 .mkml），未指定时校验项目入口。
+// 多个文件并行检查，诊断按文件顺序输出；有错误时返回 1
+int check(int argc, char* argv[], size_t jobs)
+{
+  std::vector<std::string> files;
+  bool explicit_paths = false;
+  for (int i = 2; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg.empty() || arg[0] == '-')
+    {
+      if (arg == "-j") ++i;  // -j N 的参数
+      continue;
+    }
+    explicit_paths = true;
+    std::error_code ec;
+    if (!fs::is_directory(arg, ec))
+    {
+      files.push_back(arg);
+      continue;
+    }
+    std::vector<std::string> found;
+    for (const auto& entry : fs::recursive_directory_iterator(arg, ec))
+    {
+      if (entry.is_regular_file() && entry.path().extension() == ".mkml")
+        found.push_back(entry.path().string());
+    }
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+  }
+  if (!explicit_paths)
+  {
+    json config;
+    if (!load_config(config)) return 1;
+    files = project_entries(config);
+  }
+
+  std::vector<std::vector<diagnostic>> results(files.size());
+  parallel_for(files.size(), jobs, [&](size_t i)
+  {
+    results[i] = check_mkml_file(files[i]);
+  });
+
+  size_t errors = 0, warnings = 0;
+  for (const auto& diagnostics : results)
+  {
+    for (const auto& d : diagnostics)
+    {
+      std::cerr << format_diagnostic(d) << "\n";
+      (d.level == diagnostic_level::error ? errors : warnings)++;
+    }
+  }
+  std::cout << "[mkcc] Checked " << files.size() << " file(s): " << errors
+            << " error(s), " << warnings << " warning(s)\n";
+  return errors > 0 ? 1 : 0;
+}
+
+// -j 的值必须是非负整数，0 表示 CPU 核数
+bool parse_jobs(const std::string& value, size_t& jobs)
+{
+  const char* end = value.data() + value.size();
+  auto [ptr, ec] = std::from_chars(value.data(), end, jobs);
+  if (value.empty() || ec != std::errc() || ptr != end)
+  {
+    std::cerr << "[mkcc] Invalid job count for -j: '" << value << "'\n";
+    return false;
+  }
+  return true;
+}
+
+// 解析 --profile=NAME、-jN / -j N 与 --timings、--trace=FILE。
+// 参数有误时打印错误并把 valid 设为 false，调用方返回 1
+build_options parse_build_options(int argc, char* argv[])
+{
+  build_options options;
+  for (int i = 2; i < argc && options.valid; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-j")
+    {
+      if (i + 1 < argc)
+        options.valid = parse_jobs(argv[++i], options.jobs);
+      else
+      {
+        std::cerr << "[mkcc] -j needs a job count\n";
+        options.valid = false;
+      }
+    }
+    else if (arg.rfind("-j", 0) == 0)
+      options.valid = parse_jobs(arg.substr(2), options.jobs);
+    else if (arg.rfind("--profile=", 0) == 0)
+      options.profile = arg.substr(10);
+    else if (arg == "--timings")
+      options.timings = true;
+    else if (arg.rfind("--trace=", 0) == 0)
+      options.trace_path = arg.substr(8);
+  }
+  build_trace::instance().enable(options.timings, options.trace_path);
+  return options;
+}
+
+#ifdef __linux__
+// mkcc serve 收到的请求，参数与命令行相同
+int serve_request(const std::vector<std::string>& args)
+{
+  std::vector<char*> argv = {const_cast<char*>("mkcc")};
+  for (const auto& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+  int argc = static_cast<int>(argv.size());
+  if (args[0] == "make")
+  {
+    build_options options = parse_build_options(argc, argv.data());
+    if (!options.valid) return 1;
+    int code = make(options);
+    build_trace::instance().finish();
+    return code;
+  }
+  if (args[0] == "check")
+  {
+    build_options options = parse_build_options(argc, argv.data());
+    if (!options.valid) return 1;
+    return check(argc, argv.data(), options.jobs);
+  }
+  std::cerr << "[mkcc] mkcc serve only handles make and check, not "
+            << args[0] << "\n";
+  return 1;
+}
+
+// 项目中有 mkcc serve 在运行时，make/check 交给它执行；--no-serve 时总在本进程执行
+bool forward_to_server(int argc, char* argv[], int& code)
+{
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::string(argv[i]) == "--no-serve") return false;
+    args.push_back(argv[i]);
+  }
+  std::error_code ec;
+  if (!fs::exists(SERVE_SOCKET, ec)) return false;
+  bool connected = false;
+  code = serve_forward(args, connected);
+  return connected;
+}
+#endif
+
 int main(int argc, char* argv[])
 {
   if (argc < 2)
@@ -239,6 +956,9 @@ program_dir = "C:\\Program Files\\mkcc";
 program_dir = "/usr/bin";
 #endif
 
+  // 多线程解析前必须先在主线程初始化 libxml2
+  xmlInitParser();
+
   std::string command = argv[1];
 
   if (command == "init")
@@ -250,42 +970,46 @@ program_dir = "/usr/bin";
   }
   else if (command == "--version")
   {
-    std::cout << "mkcc version 1.0.0 (markupcc compiler)\n";
+    std::cout << "mkcc version " MKCC_VERSION " (markupcc compiler)\n";
   }
 
   else if (command == "make")
   {
-    return make();
+#ifdef __linux__
+    int served = 0;
+    if (forward_to_server(argc, argv, served)) return served;
+#endif
+    // -jN / -j N 指定并行编译数，默认取 mkccmake.json 的 jobs 或 CPU 核数
+    build_options options = parse_build_options(argc, argv);
+    if (!options.valid) return 1;
+    int code = make(options);
+    build_trace::instance().finish();
+    return code;
   }
 
   else if (command == "run")
   {
-    std::ifstream json_file("mkccmake.json");
-    if (!json_file)
-    {
-      std::cerr << "[mkcc] Error: mkccmake.json not found.\n";
-      return 1;
-    }
-
     json config;
-    try
-    {
-      json_file >> config;
-    }
-    catch (const std::exception& e)
+    if (!load_config(config)) return 1;
+
+    for (int i = 2; i < argc; ++i)
     {
-      std::cerr << "[mkcc] JSON parsing error: " << e.what() << "\n";
-      return 1;
+      if (std::string(argv[i]) != "--interpret") continue;
+      bool fallback = false;
+      int code = run_interpreted(config, fallback);
+      if (!fallback) return code;
     }
 
-    std::string build = conversion_path(config.value("output", "build"));
-    std::string binary_path = PATH(build, "build.out");
+    build_options options = parse_build_options(argc, argv);
+    if (!options.valid) return 1;
+    std::string binary_path =
+        output_binary_path(config, resolve_profile(config, options));
 
     if (!fs::exists(binary_path))
     {
       std::cerr << "[mkcc] Error: build output not found: " << binary_path
                 << "\n";
-      int code=make();
+      int code=make(options);
       if (code!=0){
         return code;
       }
@@ -295,38 +1019,82 @@ program_dir = "/usr/bin";
     return std::system(binary_path.c_str());
   }
 
-  else if (command == "release")
+  else if (command == "check")
+  {
+#ifdef __linux__
+    int served = 0;
+    if (forward_to_server(argc, argv, served)) return served;
+#endif
+    build_options options = parse_build_options(argc, argv);
+    if (!options.valid) return 1;
+    return check(argc, argv, options.jobs);
+  }
+
+  else if (command == "watch")
+  {
+    return watch();
+  }
+
+  else if (command == "serve")
   {
-    std::ifstream json_file("mkccmake.json");
-    if (!json_file)
+#ifdef __linux__
+    if (argc > 2 && std::string(argv[2]) == "stop")
     {
-      std::cerr << "[mkcc] Error: mkccmake.json not found.\n";
-      return 1;
+      bool connected = false;
+      int code = serve_forward({"stop"}, connected);
+      if (!connected) std::cerr << "[mkcc] mkcc serve is not running\n";
+      return connected ? code : 1;
     }
+    return run_server(serve_request);
+#else
+    std::cerr << "[mkcc] mkcc serve requires Linux\n";
+    return 1;
+#endif
+  }
 
+  else if (command == "release")
+  {
     json config;
-    try
-    {
-      json_file >> config;
-    }
-    catch (const std::exception& e)
+    if (!load_config(config)) return 1;
+
+    // release 默认使用 release 配置档，可以用 --profile 覆盖
+    build_options options = parse_build_options(argc, argv);
+    if (!options.valid) return 1;
+    if (options.profile.empty()) options.profile = "release";
+    bool pgo = false;
+    for (int i = 2; i < argc; ++i)
     {
-      std::cerr << "[mkcc] JSON parsing error: " << e.what() << "\n";
-      return 1;
+      if (std::string(argv[i]) == "--pgo") pgo = true;
     }
 
-    std::string build = conversion_path(config.value("output", "build"));
-    std::string binary_path = PATH(build, "build.out");
     std::cout << "[mkcc] Packaging for release..." << std::endl;
-    int code=make();
+    int code = pgo ? make_pgo(config, options) : make(options);
+    build_trace::instance().finish();
       if (code!=0){
         return code;
       }
+    build_profile profile = resolve_profile(config, options);
+    if (pgo) profile.pgo = pgo_stage::use;
     std::string suffix="";
     #ifdef _WIN32
     suffix=".exe";
     #endif
-    copy_file_safe(binary_path,"release"+suffix);
+    // 多入口项目每个入口输出到目录 release-<名字>/，程序名为 <名字>
+    for (const auto& entry : project_entries(config))
+    {
+      std::string target = "release";
+      if (config.contains("entries"))
+      {
+        std::string stem = fs::path(entry).stem().string();
+        fs::path dir = "release-" + stem;
+        std::error_code ec;
+        // 旧版本在这里写的是同名文件
+        if (fs::exists(dir, ec) && !fs::is_directory(dir, ec)) fs::remove(dir, ec);
+        fs::create_directories(dir, ec);
+        target = (dir / stem).string();
+      }
+      copy_file_safe(output_binary_path(config, profile, entry), target + suffix);
+    }
     
   }
   else if (command == "help" || command == "--help" || command == "-h")
@@ -2,3 +2,12 @@ sudo cp ./mkcc /usr/bin/mkcc
 sudo cp -r ./mkcc_resource/* /usr/bin/mkcc_resource
 sudo cp  ./core/main.cpp /usr/bin/mkcc_resource
 sudo cp -r ./core/include /usr/bin/mkcc_resource
+sudo cp -r ./core/src /usr/bin/mkcc_resource
+if [ -f ./libmkccrt.a ]; then
+  sudo mkdir -p /usr/bin/mkcc_resource/lib
+  sudo cp ./libmkccrt.a ./libmkccrt.key /usr/bin/mkcc_resource/lib
+fi
+if [ -f ./mkcc_player ]; then
+  sudo mkdir -p /usr/bin/mkcc_resource/bin
+  sudo cp ./mkcc_player /usr/bin/mkcc_resource/bin
+fi
@@ -0,0 +1,30 @@
+# 运行 mkcc_codegen_dump 两次，逐个比较两次生成的文件
+#   cmake -DDUMP=<mkcc_codegen_dump> -DMKML=<fixture> -DWORK=<目录> -P check_deterministic.cmake
+file(REMOVE_RECURSE "${WORK}")
+foreach(run a b)
+  execute_process(COMMAND "${DUMP}" "${MKML}" "${WORK}/${run}"
+                  RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "mkcc_codegen_dump failed (${result})")
+  endif()
+endforeach()
+
+file(GLOB units_a RELATIVE "${WORK}/a" "${WORK}/a/*")
+file(GLOB units_b RELATIVE "${WORK}/b" "${WORK}/b/*")
+list(SORT units_a)
+list(SORT units_b)
+if(NOT units_a STREQUAL units_b)
+  message(FATAL_ERROR "generated files differ: [${units_a}] vs [${units_b}]")
+endif()
+list(LENGTH units_a count)
+if(count LESS 3)
+  message(FATAL_ERROR "expected main.cpp and two script units, got [${units_a}]")
+endif()
+foreach(unit IN LISTS units_a)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                          "${WORK}/a/${unit}" "${WORK}/b/${unit}"
+                  RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "${unit} differs between two runs")
+  endif()
+endforeach()
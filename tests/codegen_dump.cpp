@@ -0,0 +1,60 @@
+// 代码生成确定性测试的辅助程序：解析 MKML 文件两次并各生成一次翻译单元，
+// 两次结果有任何字节不同即失败；否则把结果写入输出目录，由
+// check_deterministic.cmake 比较两个进程的输出
+//
+//   mkcc_codegen_dump <mkml 文件> <输出目录>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../include/compiler.h"
+
+static std::vector<generated_unit> generate(const char* path, const main_template& tmpl)
+{
+  std::shared_ptr<const mkml_document> doc = load_mkml_file(path);
+  if (!doc) return {};
+  return generate_units(*doc->root, tmpl);
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc != 3)
+  {
+    std::fprintf(stderr, "usage: %s <mkml> <out dir>\n", argv[0]);
+    return 2;
+  }
+  xmlInitParser();
+  const main_template& tmpl = load_main_template(MKCC_MAIN_TEMPLATE);
+  if (tmpl.insertions.empty())
+  {
+    std::fprintf(stderr, "Cannot read template %s\n", MKCC_MAIN_TEMPLATE);
+    return 1;
+  }
+
+  std::vector<generated_unit> first = generate(argv[1], tmpl);
+  std::vector<generated_unit> second = generate(argv[1], tmpl);
+  if (first.empty())
+  {
+    std::fprintf(stderr, "Cannot parse %s\n", argv[1]);
+    return 1;
+  }
+  if (first.size() != second.size())
+  {
+    std::fprintf(stderr, "unit count differs: %zu vs %zu\n", first.size(),
+                 second.size());
+    return 1;
+  }
+  for (size_t i = 0; i < first.size(); ++i)
+  {
+    if (first[i].file != second[i].file || first[i].source != second[i].source)
+    {
+      std::fprintf(stderr, "%s differs between two runs\n", first[i].file.c_str());
+      return 1;
+    }
+  }
+
+  std::filesystem::create_directories(argv[2]);
+  for (const generated_unit& unit : first)
+    write_file(std::string(argv[2]) + "/" + unit.file, unit.source);
+  return 0;
+}
@@ -0,0 +1,60 @@
+// 滚动后离开窗口的元素必须随之移出窗口，不能停留在原来的屏幕位置上
+// 继续被悬停或点中。需要显示器（或 Xvfb）；没有 DISPLAY 时跳过
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "div.h"
+
+static int failures = 0;
+
+static void expect(bool ok, const char *what)
+{
+  if (!ok)
+  {
+    std::fprintf(stderr, "FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+int main()
+{
+#ifdef __linux__
+  if (!std::getenv("DISPLAY"))
+  {
+    std::puts("no display, skipped");
+    return 77;
+  }
+#endif
+  windowWidth = 400;
+  windowHeight = 300;
+  sf::RenderWindow window(sf::VideoMode(windowWidth, windowHeight),
+                          "render_scroll_test");
+  // 未加载的字体没有字形，按钮只有 padding 的大小，不需要字体文件
+  sf::Font font;
+  Div root(10, 10);
+  for (int i = 0; i < 200; ++i)
+    root.addButton("button " + std::to_string(i), font);
+  const Button &top = *root.elements[0].button;
+  const Button &lower = *root.elements[5].button;
+
+  scrollOffset = 0.f;
+  root.draw(window);
+  float topY = top.y, lowerY = lower.y;
+  expect(topY >= 0 && lowerY + lower.height <= windowHeight,
+         "buttons start inside the window");
+
+  // 一次滚动越过整个窗口：原来可见的按钮都应移到窗口上方
+  scrollOffset = 2000.f;
+  root.draw(window);
+  expect(top.y + top.height < 0, "first button moved above the window");
+  expect(lower.y + lower.height < 0, "sixth button moved above the window");
+  expect(top.y == topY - 2000.f, "first button follows the scroll");
+
+  // 滚回原处后回到原来的位置
+  scrollOffset = 0.f;
+  root.draw(window);
+  expect(top.y == topY && lower.y == lowerY, "buttons return after scrolling back");
+
+  return failures == 0 ? 0 : 1;
+}